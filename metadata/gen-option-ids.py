@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+#
+# Generates wf-shell-options.hpp from the metadata files: a typed key for
+# every option, so that options are looked up by index and a misspelled
+# option name fails to compile.
+#
+# Usage: gen-option-ids.py OUTPUT METADATA...
+
+import keyword
+import sys
+import xml.etree.ElementTree as ET
+
+# Metadata types and the types of their values. Other types, such as
+# dynamic lists, are still looked up by name.
+TYPES = {
+    'int': 'int',
+    'bool': 'bool',
+    'double': 'double',
+    'string': 'std::string',
+    'color': 'wf::color_t',
+}
+
+CPP_KEYWORDS = {
+    'auto', 'bool', 'case', 'char', 'class', 'default', 'delete', 'double',
+    'float', 'int', 'long', 'namespace', 'new', 'operator', 'private',
+    'protected', 'public', 'short', 'signed', 'static', 'switch', 'template',
+    'this', 'union', 'unsigned', 'using', 'virtual', 'void',
+}
+
+def identifier(name):
+    if name in CPP_KEYWORDS or keyword.iskeyword(name):
+        return name + '_'
+    return name
+
+def main():
+    output = sys.argv[1]
+    sections = []
+    index = 0
+    for path in sys.argv[2:]:
+        root = ET.parse(path).getroot()
+        for plugin in root.iter('plugin'):
+            options = []
+            for option in plugin.iter('option'):
+                type = TYPES.get(option.get('type'))
+                if type is None:
+                    continue
+                options.append((identifier(option.get('name')), type,
+                    plugin.get('name') + '/' + option.get('name'), index))
+                index += 1
+            sections.append((identifier(plugin.get('name')), options))
+
+    lines = [
+        '/* Generated by gen-option-ids.py from the metadata files, do not edit */',
+        '#ifndef WF_SHELL_OPTIONS_HPP',
+        '#define WF_SHELL_OPTIONS_HPP',
+        '',
+        '#include <string>',
+        '#include <wayfire/config/types.hpp>',
+        '#include "wf-option-key.hpp"',
+        '',
+        'namespace WfOptions',
+        '{',
+        'constexpr int count = %d;' % index,
+    ]
+    for section, options in sections:
+        lines += ['', 'namespace %s' % section, '{']
+        for name, type, full_name, i in options:
+            lines.append('constexpr WfOptionKey<%s> %s{%d, "%s"};' %
+                (type, name, i, full_name))
+        lines.append('}')
+    lines += ['}', '', '#endif /* end of include guard: WF_SHELL_OPTIONS_HPP */', '']
+
+    with open(output, 'w') as f:
+        f.write('\n'.join(lines))
+
+if __name__ == '__main__':
+    main()
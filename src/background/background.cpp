@@ -1,15 +1,14 @@
-#include <wordexp.h>
 #include <glibmm/main.h>
 #include <gtkmm/drawingarea.h>
 #include <gtkmm/window.h>
 #include <gtkmm/image.h>
 #include <gdkmm/pixbuf.h>
 #include <gdkmm/general.h>
+#include <gdkmm/display.h>
 #include <gdk/gdkwayland.h>
 
-#include <random>
 #include <algorithm>
-
+#include <cmath>
 #include <iostream>
 #include <map>
 
@@ -19,246 +18,489 @@
 #include "background.hpp"
 
 
-void BackgroundDrawingArea::show_image(Glib::RefPtr<Gdk::Pixbuf> image,
-    double offset_x, double offset_y)
+Cairo::RefPtr<Cairo::Surface> BackgroundDrawingArea::create_native_surface(
+    const Cairo::RefPtr<Cairo::Surface>& source)
+{
+    auto window = get_window();
+    if (!window)
+    {
+        return source;
+    }
+
+    return BackgroundPainter::create_native_surface(source,
+        [=] (Cairo::Content content, int width, int height)
+    {
+        return window->create_similar_surface(content, width, height);
+    });
+}
+
+void BackgroundDrawingArea::show_image(BackgroundImageCache::image_t image,
+    int origin_x, int origin_y)
 {
+    frame_conn.disconnect();
     if (!image)
     {
-        to_image.source.clear();
-        from_image.source.clear();
+        to_image   = {};
+        from_image = {};
+        queue_draw();
         return;
     }
 
     from_image = to_image;
-    to_image.source = Gdk::Cairo::create_surface_from_pixbuf(image,
-        this->get_scale_factor());
+    to_image.image = image;
+    to_image.frame = 0;
+    /* Animations are painted from the shared frames, converting each of
+     * them would cost more than it saves */
+    to_image.source = image->frames.empty() ?
+        create_native_surface(image->source) : image->source;
+
+    /* The offsets are in the pixels of the image, which may be shared with
+     * outputs of a different scale */
+    to_image.x = image->offset_x / image->request.scale - origin_x;
+    to_image.y = image->offset_y / image->request.scale - origin_y;
+    if (auto surface = Cairo::RefPtr<Cairo::ImageSurface>::cast_dynamic(image->source))
+    {
+        double scale_x, scale_y;
+        cairo_surface_get_device_scale(surface->cobj(), &scale_x, &scale_y);
+        to_image.width  = surface->get_width() / scale_x;
+        to_image.height = surface->get_height() / scale_y;
+    }
 
-    to_image.x = offset_x / this->get_scale_factor();
-    to_image.y = offset_y / this->get_scale_factor();
-    fade.animate(from_image.source ? 0.0 : 1.0, 1.0);
+    frame_start = get_frame_time();
+    schedule_next_frame();
+    /* Nobody would see the fade while the output is covered */
+    fade.animate((from_image.source && !paused) ? 0.0 : 1.0, 1.0);
 
-    Glib::signal_idle().connect_once([=] ()
+    if (fade.running() && !tick_id)
     {
-        this->queue_draw();
-    });
+        tick_id = add_tick_callback(sigc::mem_fun(this, &BackgroundDrawingArea::on_tick));
+    }
+
+    queue_draw();
 }
 
-bool BackgroundDrawingArea::on_draw(const Cairo::RefPtr<Cairo::Context>& cr)
+void BackgroundDrawingArea::set_paused(bool paused)
 {
-    if (!to_image.source)
+    this->paused = paused;
+    if (!paused)
     {
-        return false;
+        /* Continue the animation from the frame it was stopped at */
+        frame_start = get_frame_time();
+        schedule_next_frame();
+        return;
     }
 
+    frame_conn.disconnect();
     if (fade.running())
     {
+        /* Skip to the end of the fade */
+        fade.animate(1.0, 1.0);
+        from_image = {};
+        if (tick_id)
+        {
+            remove_tick_callback(tick_id);
+            tick_id = 0;
+        }
+
         queue_draw();
     }
+}
 
-    cr->set_source(to_image.source, to_image.x, to_image.y);
-    cr->paint_with_alpha(fade);
-    if (!from_image.source)
+bool BackgroundDrawingArea::on_tick(const Glib::RefPtr<Gdk::FrameClock>& clock)
+{
+    queue_draw();
+    if (fade.running())
     {
-        return false;
+        return true;
     }
 
-    cr->set_source(from_image.source, from_image.x, from_image.y);
-    cr->paint_with_alpha(1.0 - fade);
+    /* The outgoing image is fully covered now, stop painting it */
+    from_image = {};
+    tick_id    = 0;
     return false;
 }
 
-BackgroundDrawingArea::BackgroundDrawingArea()
+gint64 BackgroundDrawingArea::get_frame_time()
 {
-    fade.animate(0, 0);
+    auto clock = get_frame_clock();
+    return clock ? clock->get_frame_time() : g_get_monotonic_time();
 }
 
-Glib::RefPtr<Gdk::Pixbuf> WayfireBackground::create_from_file_safe(std::string path)
+void BackgroundDrawingArea::schedule_next_frame()
 {
-    Glib::RefPtr<Gdk::Pixbuf> pbuf;
-    int width  = window.get_allocated_width() * scale;
-    int height = window.get_allocated_height() * scale;
+    frame_conn.disconnect();
+    if (paused || !to_image.image || to_image.image->frames.empty())
+    {
+        return;
+    }
 
-    try {
-        pbuf =
-            Gdk::Pixbuf::create_from_file(path, width, height,
-                background_preserve_aspect);
-    } catch (...)
+    int delay = to_image.image->frames[to_image.frame].delay;
+    if (delay < 0)
     {
-        return Glib::RefPtr<Gdk::Pixbuf>();
+        /* The animation has ended */
+        return;
     }
 
-    if (background_preserve_aspect)
+    gint64 due = frame_start + delay * 1000 - get_frame_time();
+    frame_conn = WfStats::signal_timeout().connect(
+        sigc::mem_fun(this, &BackgroundDrawingArea::next_frame),
+        std::max<gint64>(due / 1000, 0));
+}
+
+bool BackgroundDrawingArea::next_frame()
+{
+    auto& frames = to_image.image->frames;
+    gint64 now   = get_frame_time();
+    size_t shown = to_image.frame;
+
+    /* Skip frames which are already over, if the main loop was busy */
+    int delay;
+    while (((delay = frames[to_image.frame].delay) >= 0) &&
+           (now >= frame_start + delay * 1000))
     {
-        bool eq_width = (width == pbuf->get_width());
-        offset_x = eq_width ? 0 : (width - pbuf->get_width()) * 0.5;
-        offset_y = eq_width ? (height - pbuf->get_height()) * 0.5 : 0;
-    } else
+        frame_start   += delay * 1000;
+        to_image.frame = (to_image.frame + 1) % frames.size();
+    }
+
+    if (to_image.frame != shown)
     {
-        offset_x = offset_y = 0.0;
+        to_image.source = frames[to_image.frame].surface;
+        queue_draw();
     }
 
-    return pbuf;
+    schedule_next_frame();
+    return false;
 }
 
-bool WayfireBackground::change_background(int timer)
+void BackgroundDrawingArea::set_fill(const BackgroundFill& fill)
 {
-    Glib::RefPtr<Gdk::Pixbuf> pbuf;
-    std::string path;
+    painter.set_fill(fill);
+    queue_draw();
+}
 
-    if (!load_next_background(pbuf, path))
+bool BackgroundDrawingArea::on_draw(const Cairo::RefPtr<Cairo::Context>& cr)
+{
+    painter.paint(cr, get_allocated_width(), get_allocated_height(),
+        to_image, from_image, fade.running() ? (double)fade : 1.0);
+    return false;
+}
+
+BackgroundDrawingArea::BackgroundDrawingArea()
+{
+    fade.animate(0, 0);
+}
+
+/* Returns the bounding box of all monitors in logical coordinates, and the
+ * largest scale among them */
+static Gdk::Rectangle get_span_geometry(int& max_scale)
+{
+    Gdk::Rectangle span;
+    max_scale = 1;
+
+    auto display = Gdk::Display::get_default();
+    for (int i = 0; i < display->get_n_monitors(); i++)
     {
-        return false;
+        auto monitor = display->get_monitor(i);
+        Gdk::Rectangle geometry;
+        monitor->get_geometry(geometry);
+
+        span = (i == 0) ? geometry : span.join(geometry);
+        max_scale = std::max(max_scale, monitor->get_scale_factor());
     }
 
-    std::cout << "Loaded " << path << std::endl;
-    drawing_area.show_image(pbuf, offset_x, offset_y);
-    return true;
+    return span;
 }
 
-bool WayfireBackground::load_images_from_dir(std::string path)
+BackgroundImageRequest WayfireBackground::make_request(const std::string& path)
 {
-    wordexp_t exp;
-
-    /* Expand path */
-    if (wordexp(path.c_str(), &exp, 0))
+    if (background_span_outputs)
     {
-        return false;
+        /* One image for the whole layout, at the scale of the sharpest
+         * output. Every output uses the same request, so it is decoded
+         * once and shared through the cache. */
+        int span_scale;
+        auto span = get_span_geometry(span_scale);
+        return {
+            path,
+            span.get_width() * span_scale,
+            span.get_height() * span_scale,
+            span_scale,
+            background_preserve_aspect,
+            std::max(0, (int)background_blur_radius) * span_scale,
+            std::clamp((double)background_dim, 0.0, 1.0),
+        };
     }
 
-    if (!exp.we_wordc)
+    return {
+        path,
+        window.get_allocated_width() * scale,
+        window.get_allocated_height() * scale,
+        scale,
+        background_preserve_aspect,
+        std::max(0, (int)background_blur_radius) * scale,
+        std::clamp((double)background_dim, 0.0, 1.0),
+    };
+}
+
+void WayfireBackground::show_loaded_image(BackgroundImageCache::image_t image)
+{
+    int origin_x = 0, origin_y = 0;
+    if (background_span_outputs)
     {
-        wordfree(&exp);
-        return false;
+        /* Position of this output inside the spanned image */
+        int span_scale;
+        auto span = get_span_geometry(span_scale);
+        Gdk::Rectangle geometry;
+        output->monitor->get_geometry(geometry);
+        origin_x = geometry.get_x() - span.get_x();
+        origin_y = geometry.get_y() - span.get_y();
     }
 
-    auto dir = opendir(exp.we_wordv[0]);
-    if (!dir)
+    drawing_area.show_image(image, origin_x, origin_y);
+    release_inhibit();
+
+    if (image)
     {
-        wordfree(&exp);
-        return false;
+        std::cout << "Loaded " << image->request.path << " (" <<
+            cache->memory_usage() / (1024 * 1024) << " MiB of wallpapers in memory)" <<
+            std::endl;
     }
+}
 
-    /* Iterate over all files in the directory */
-    dirent *file;
-    while ((file = readdir(dir)) != 0)
+bool WayfireBackground::fits_memory_budget(const BackgroundImageRequest& request)
+{
+    if (background_memory_budget <= 0)
     {
-        /* Skip hidden files and folders */
-        if (file->d_name[0] == '.')
-        {
-            continue;
-        }
+        return true;
+    }
 
-        auto fullpath = std::string(exp.we_wordv[0]) + "/" + file->d_name;
+    size_t budget = (size_t)background_memory_budget * 1024 * 1024;
+    size_t needed = (size_t)request.width * request.height * 4;
+    return cache->memory_usage() + needed <= budget;
+}
 
-        struct stat next;
-        if (stat(fullpath.c_str(), &next) == 0)
-        {
-            if (S_ISDIR(next.st_mode))
-            {
-                /* Recursive search */
-                load_images_from_dir(fullpath);
-            } else
-            {
-                images.push_back(fullpath);
-            }
-        }
+void WayfireBackground::release_inhibit()
+{
+    if (inhibited && output->output)
+    {
+        zwf_output_v2_inhibit_output_done(output->output);
+        inhibited = false;
     }
+}
 
-    wordfree(&exp);
+bool WayfireBackground::has_images() const
+{
+    return index && index->size();
+}
 
-    if (background_randomize && images.size())
+bool WayfireBackground::change_background()
+{
+    if (!index || !index->size() || output->fullscreen)
     {
-        std::random_device random_device;
-        std::mt19937 random_gen(random_device());
-        std::shuffle(images.begin(), images.end(), random_gen);
+        return false;
+    }
+
+    if (cache->busy(this))
+    {
+        /* The next image is still being decoded, switch as soon as it is
+         * ready instead of decoding it a second time. */
+        switch_when_loaded = true;
+        return true;
     }
 
+    load_next_background();
     return true;
 }
 
-bool WayfireBackground::load_next_background(Glib::RefPtr<Gdk::Pixbuf> & pbuf,
-    std::string & path)
+void WayfireBackground::choose_next_image(uint64_t step)
 {
-    while (!pbuf)
+    next_step = step;
+    if (background_randomize && background_span_outputs && (index->size() > 1))
     {
-        if (!images.size())
+        /* All outputs must agree on the image, so use the index's shared
+         * sequence of random positions instead of picking independently */
+        next_background = index->shuffled_position(step);
+        if (index->at(next_background) == current_image)
         {
-            std::cerr << "Failed to load background images from " <<
-                    (std::string)background_image << std::endl;
-            window.remove();
-            return false;
+            next_background = (next_background + 1) % index->size();
         }
+    } else if (background_randomize && (index->size() > 1))
+    {
+        /* Avoid showing the same image twice in a row */
+        do {
+            next_background = index->random_position();
+        } while (index->at(next_background) == current_image);
+    } else
+    {
+        /* Outputs cycling through the same directory show the same image */
+        next_background = step % index->size();
+    }
 
-        current_background = (current_background + 1) % images.size();
+    next_image = index->at(next_background);
+}
 
-        path = images[current_background];
-        pbuf = create_from_file_safe(path);
+void WayfireBackground::load_next_background()
+{
+    if (!index->size())
+    {
+        std::cerr << "Failed to load background images from " <<
+            (std::string)background_image << std::endl;
+        show_loaded_image(nullptr);
+        return;
+    }
 
-        if (!pbuf)
+    /* The prefetched image is stale if cycles were skipped, e.g. while the
+     * output was fullscreen */
+    if (!index->contains(next_image) || (next_step != scheduler->get_step()))
+    {
+        choose_next_image(scheduler->get_step());
+    }
+
+    cache->load(make_request(next_image), this, [=] (
+        const BackgroundImageRequest& request, BackgroundImageCache::image_t image)
+    {
+        if (!image)
         {
-            images.erase(images.begin() + current_background);
+            index->remove(request.path);
+            next_image.clear();
+            load_next_background();
+            return;
         }
+
+        current_background = next_background;
+        current_image = request.path;
+        next_image.clear();
+        switch_when_loaded = false;
+        prefetched.reset();
+        show_loaded_image(image);
+        prefetch_next_background();
+    });
+}
+
+void WayfireBackground::prefetch_next_background()
+{
+    if ((index->size() < 2) || output->fullscreen)
+    {
+        return;
     }
 
-    return true;
+    /* Keeping a reference to the image keeps it in the cache, so the next
+     * call to load_next_background() does not need to decode it. */
+    choose_next_image(scheduler->get_step() + 1);
+    auto request = make_request(next_image);
+    if (!cache->lookup(request) && !fits_memory_budget(request))
+    {
+        /* It will be decoded when the cycle timer fires instead */
+        return;
+    }
+
+    prefetch_pending = true;
+    cache->load(request, this, [=] (
+        const BackgroundImageRequest& request, BackgroundImageCache::image_t image)
+    {
+        prefetch_pending = false;
+        if (!image)
+        {
+            index->remove(request.path);
+            prefetch_next_background();
+            return;
+        }
+
+        prefetched = image;
+        if (switch_when_loaded)
+        {
+            switch_when_loaded = false;
+            load_next_background();
+        }
+    });
 }
 
 void WayfireBackground::reset_background()
 {
-    images.clear();
     current_background = 0;
-    change_bg_conn.disconnect();
+    current_image.clear();
+    next_image.clear();
+    cache->cancel(this);
+    prefetched.reset();
+    prefetch_pending   = false;
+    switch_when_loaded = false;
     scale = window.get_scale_factor();
 }
 
 void WayfireBackground::set_background()
 {
-    Glib::RefPtr<Gdk::Pixbuf> pbuf;
-
     reset_background();
 
     std::string path = background_image;
-    try {
-        if (load_images_from_dir(path) && images.size())
-        {
-            if (!load_next_background(pbuf, path))
-            {
-                throw std::exception();
-            }
 
-            std::cout << "Loaded " << path << std::endl;
-        } else
+    /* The index is shared and kept up to date, so this only scans the
+     * directory if the image option changed. */
+    auto new_index = BackgroundImageIndex::Launch(path);
+    if (new_index != index)
+    {
+        index_changed_conn.disconnect();
+        index = new_index;
+        if (index)
         {
-            pbuf = create_from_file_safe(path);
-            if (!pbuf)
+            index_changed_conn = index->signal_changed().connect([=] ()
             {
-                throw std::exception();
-            }
+                scheduler->update_cycle_timeout();
+                /* Start cycling if images appeared in an empty directory */
+                if (current_image.empty() && !cache->busy(this) && index->size())
+                {
+                    set_background();
+                }
+            });
         }
-    } catch (...)
-    {
-        std::cerr << "Failed to load background image(s) " << path << std::endl;
     }
 
-    reset_cycle_timeout();
-    drawing_area.show_image(pbuf, offset_x, offset_y);
-
-    if (inhibited && output->output)
+    scheduler->update_cycle_timeout();
+    if (index && index->size())
     {
-        zwf_output_v2_inhibit_output_done(output->output);
-        inhibited = false;
+        load_next_background();
+    } else if (path.empty())
+    {
+        /* Only the fill is drawn, nothing to decode */
+        show_loaded_image(nullptr);
+    } else
+    {
+        cache->load(make_request(path), this, [=] (
+            const BackgroundImageRequest& request, BackgroundImageCache::image_t image)
+        {
+            if (!image)
+            {
+                std::cerr << "Failed to load background image(s) " << path << std::endl;
+            }
+
+            show_loaded_image(image);
+        });
     }
 }
 
-void WayfireBackground::reset_cycle_timeout()
+void WayfireBackground::update_fill()
 {
-    int cycle_timeout = background_cycle_timeout * 1000;
-    change_bg_conn.disconnect();
-    if (images.size())
+    BackgroundFill fill;
+    std::string type = background_fill;
+    if (type == "linear")
     {
-        change_bg_conn = Glib::signal_timeout().connect(sigc::bind(sigc::mem_fun(
-            this, &WayfireBackground::change_background), 0), cycle_timeout);
+        fill.type = BackgroundFill::LINEAR;
+    } else if (type == "radial")
+    {
+        fill.type = BackgroundFill::RADIAL;
+    } else
+    {
+        if (type != "solid")
+        {
+            std::cerr << "Invalid background fill " << type << std::endl;
+        }
+
+        fill.type = BackgroundFill::SOLID;
     }
+
+    fill.color = background_color;
+    fill.gradient_color = background_gradient_color;
+    fill.angle = background_gradient_angle;
+    drawing_area.set_fill(fill);
 }
 
 void WayfireBackground::setup_window()
@@ -279,20 +521,30 @@ void WayfireBackground::setup_window()
     window.show_all();
 
     auto reset_background = [=] () { set_background(); };
-    auto reset_cycle = [=] () { reset_cycle_timeout(); };
     background_image.set_callback(reset_background);
     background_randomize.set_callback(reset_background);
     background_preserve_aspect.set_callback(reset_background);
-    background_cycle_timeout.set_callback(reset_cycle);
+    background_span_outputs.set_callback(reset_background);
+    background_blur_radius.set_callback(reset_background);
+    background_dim.set_callback(reset_background);
+
+    auto reset_fill = [=] () { update_fill(); };
+    background_fill.set_callback(reset_fill);
+    background_color.set_callback(reset_fill);
+    background_gradient_color.set_callback(reset_fill);
+    background_gradient_angle.set_callback(reset_fill);
+    update_fill();
 
     window.property_scale_factor().signal_changed().connect(
         sigc::mem_fun(this, &WayfireBackground::set_background));
 }
 
-WayfireBackground::WayfireBackground(WayfireShellApp *app, WayfireOutput *output)
+WayfireBackground::WayfireBackground(WayfireShellApp *app, WayfireOutput *output,
+    BackgroundCycleScheduler *scheduler)
 {
     this->app    = app;
     this->output = output;
+    this->scheduler = scheduler;
 
     if (output->output)
     {
@@ -302,6 +554,12 @@ WayfireBackground::WayfireBackground(WayfireShellApp *app, WayfireOutput *output
 
     setup_window();
 
+    enter_fullscreen_conn = output->enter_fullscreen_signal().connect(
+        sigc::mem_fun(this, &WayfireBackground::handle_fullscreen_changed));
+    leave_fullscreen_conn = output->leave_fullscreen_signal().connect(
+        sigc::mem_fun(this, &WayfireBackground::handle_fullscreen_changed));
+    drawing_area.set_paused(output->fullscreen);
+
     this->window.signal_size_allocate().connect_notify(
         [this, width = 0, height = 0] (Gtk::Allocation& alloc) mutable
     {
@@ -314,33 +572,189 @@ WayfireBackground::WayfireBackground(WayfireShellApp *app, WayfireOutput *output
     });
 }
 
-class WayfireBackgroundApp : public WayfireShellApp
+void WayfireBackground::handle_fullscreen_changed()
 {
-    std::map<WayfireOutput*, std::unique_ptr<WayfireBackground>> backgrounds;
+    drawing_area.set_paused(output->fullscreen);
+    if (output->fullscreen)
+    {
+        /* Nothing changes behind a fullscreen view, so the scheduler
+         * skips this output and images which nobody would see are not
+         * decoded. Images which are about to be shown are still loaded,
+         * just without a fade. */
+        if (prefetch_pending && !switch_when_loaded)
+        {
+            cache->cancel(this);
+            prefetch_pending = false;
+        }
 
-  public:
-    using WayfireShellApp::WayfireShellApp;
-    static void create(int argc, char **argv)
+        return;
+    }
+
+    bool prefetch_stale = prefetched && (next_step != scheduler->get_step() + 1);
+    if (index && (!prefetched || prefetch_stale) && !cache->busy(this))
     {
-        WayfireShellApp::instance =
-            std::make_unique<WayfireBackgroundApp>(argc, argv);
-        instance->run();
+        prefetch_next_background();
     }
+}
 
-    void handle_new_output(WayfireOutput *output) override
+void WayfireBackground::handle_layout_changed()
+{
+    if (background_span_outputs)
     {
-        backgrounds[output] = std::unique_ptr<WayfireBackground>(
-            new WayfireBackground(this, output));
+        set_background();
     }
+}
+
+WayfireBackground::~WayfireBackground()
+{
+    enter_fullscreen_conn.disconnect();
+    leave_fullscreen_conn.disconnect();
+    index_changed_conn.disconnect();
+    cache->cancel(this);
+}
 
-    void handle_output_removed(WayfireOutput *output) override
+BackgroundCycleScheduler::BackgroundCycleScheduler()
+{
+    background_cycle_timeout.set_callback([=] () { reset_cycle_timeout(); });
+    reset_cycle_timeout();
+}
+
+BackgroundCycleScheduler::~BackgroundCycleScheduler()
+{
+    cycle_conn.disconnect();
+    stagger_conn.disconnect();
+}
+
+void BackgroundCycleScheduler::add(WayfireBackground *background)
+{
+    backgrounds.push_back(background);
+    update_cycle_timeout();
+}
+
+void BackgroundCycleScheduler::remove(WayfireBackground *background)
+{
+    backgrounds.erase(std::remove(backgrounds.begin(), backgrounds.end(), background),
+        backgrounds.end());
+    pending.erase(std::remove(pending.begin(), pending.end(), background),
+        pending.end());
+    update_cycle_timeout();
+}
+
+uint64_t BackgroundCycleScheduler::get_step() const
+{
+    return step;
+}
+
+void BackgroundCycleScheduler::reset_cycle_timeout()
+{
+    cycle_conn.disconnect();
+    update_cycle_timeout();
+}
+
+void BackgroundCycleScheduler::update_cycle_timeout()
+{
+    /* A timeout of 0 would fire continuously, and without images there is
+     * nothing to cycle */
+    bool has_images = std::any_of(backgrounds.begin(), backgrounds.end(),
+        [] (WayfireBackground *background) { return background->has_images(); });
+    if ((background_cycle_timeout <= 0) || !has_images)
+    {
+        cycle_conn.disconnect();
+        return;
+    }
+
+    if (!cycle_conn.connected())
+    {
+        cycle_conn = WfStats::signal_timeout().connect(
+            sigc::mem_fun(this, &BackgroundCycleScheduler::cycle),
+            background_cycle_timeout * 1000);
+    }
+}
+
+bool BackgroundCycleScheduler::cycle()
+{
+    /* Finish a staggered cycle which took longer than the timeout */
+    stagger_conn.disconnect();
+    while (switch_next())
+    {}
+
+    step++;
+    pending = backgrounds;
+    if (background_cycle_stagger <= 0)
+    {
+        /* Outputs with prefetched images all switch before the next frame */
+        while (switch_next())
+        {}
+    } else if (switch_next())
+    {
+        stagger_conn = WfStats::signal_timeout().connect(
+            sigc::mem_fun(this, &BackgroundCycleScheduler::switch_next),
+            background_cycle_stagger);
+    }
+
+    return true;
+}
+
+bool BackgroundCycleScheduler::switch_next()
+{
+    /* Outputs which don't cycle don't take up a slot */
+    while (!pending.empty())
     {
-        backgrounds.erase(output);
+        auto background = pending.front();
+        pending.erase(pending.begin());
+        if (background->change_background())
+        {
+            break;
+        }
     }
-};
 
-int main(int argc, char **argv)
+    return !pending.empty();
+}
+
+void WayfireBackgroundApp::create()
+{
+    WayfireShellApp::get().add_component(
+        std::unique_ptr<WayfireShellComponent>(new WayfireBackgroundApp()));
+}
+
+WayfireBackgroundApp::~WayfireBackgroundApp()
 {
-    WayfireBackgroundApp::create(argc, argv);
-    return 0;
+    for (auto& conn : geometry_conns)
+    {
+        conn.second.disconnect();
+    }
+}
+
+void WayfireBackgroundApp::on_activate()
+{
+    scheduler = std::make_unique<BackgroundCycleScheduler>();
+}
+
+void WayfireBackgroundApp::handle_new_output(WayfireOutput *output)
+{
+    backgrounds[output] = std::unique_ptr<WayfireBackground>(
+        new WayfireBackground(&WayfireShellApp::get(), output, scheduler.get()));
+    scheduler->add(backgrounds[output].get());
+
+    geometry_conns[output].disconnect();
+    geometry_conns[output] = output->monitor->property_geometry().signal_changed().connect(
+        sigc::mem_fun(this, &WayfireBackgroundApp::handle_layout_changed));
+    handle_layout_changed();
+}
+
+void WayfireBackgroundApp::handle_output_removed(WayfireOutput *output)
+{
+    geometry_conns[output].disconnect();
+    geometry_conns.erase(output);
+    scheduler->remove(backgrounds[output].get());
+    backgrounds.erase(output);
+    handle_layout_changed();
+}
+
+void WayfireBackgroundApp::handle_layout_changed()
+{
+    for (auto& background : backgrounds)
+    {
+        background.second->handle_layout_changed();
+    }
 }
@@ -5,16 +5,19 @@
 #include <gtkmm/window.h>
 #include <wf-shell-app.hpp>
 #include <wf-option-wrap.hpp>
+#include <wf-stats.hpp>
 #include <wayfire/util/duration.hpp>
+#include <wayfire/config/types.hpp>
 
-class WayfireBackground;
+#include <map>
+#include <memory>
 
-class BackgroundImage
-{
-  public:
-    double x, y;
-    Cairo::RefPtr<Cairo::Surface> source;
-};
+#include "image-cache.hpp"
+#include "image-index.hpp"
+#include "painter.hpp"
+
+class WayfireBackground;
+class BackgroundCycleScheduler;
 
 class BackgroundDrawingArea : public Gtk::DrawingArea
 {
@@ -30,10 +33,35 @@ class BackgroundDrawingArea : public Gtk::DrawingArea
      * are used as offsets when preserve aspect is set. */
     BackgroundImage to_image, from_image;
 
+    BackgroundPainter painter;
+
+    /* Redraws are driven by the frame clock while fading */
+    guint tick_id = 0;
+    bool paused   = false;
+    bool on_tick(const Glib::RefPtr<Gdk::FrameClock>& clock);
+
+    /* Animations only wake up when their next frame is due, instead of on
+     * every frame of the display. The time at which the shown frame started
+     * is taken from the frame clock. */
+    sigc::connection frame_conn;
+    gint64 frame_start = 0;
+    gint64 get_frame_time();
+    void schedule_next_frame();
+    bool next_frame();
+
+    Cairo::RefPtr<Cairo::Surface> create_native_surface(
+        const Cairo::RefPtr<Cairo::Surface>& source);
+
   public:
     BackgroundDrawingArea();
-    void show_image(Glib::RefPtr<Gdk::Pixbuf> image,
-        double offset_x, double offset_y);
+    /* Show the given image. origin_x and origin_y are the position of the
+     * output inside the image, when it spans multiple outputs. */
+    void show_image(BackgroundImageCache::image_t image,
+        int origin_x = 0, int origin_y = 0);
+    void set_fill(const BackgroundFill& fill);
+    /* While paused, images are switched without a fade and animations
+     * are stopped */
+    void set_paused(bool paused);
 
   protected:
     bool on_draw(const Cairo::RefPtr<Cairo::Context>& cr) override;
@@ -43,33 +71,135 @@ class WayfireBackground
 {
     WayfireShellApp *app;
     WayfireOutput *output;
+    BackgroundCycleScheduler *scheduler;
+    /* Shared between the backgrounds of all outputs */
+    std::shared_ptr<BackgroundImageCache> cache = BackgroundImageCache::Launch();
 
     BackgroundDrawingArea drawing_area;
-    std::vector<std::string> images;
+    std::shared_ptr<BackgroundImageIndex> index;
+    sigc::connection index_changed_conn;
     Gtk::Window window;
 
     int scale;
-    double offset_x, offset_y;
     bool inhibited = false;
-    uint current_background;
-    sigc::connection change_bg_conn;
+    size_t current_background;
+    std::string current_image;
+    /* The image which will be shown when the cycle timer fires next, and the
+     * step of the scheduler it was chosen for */
+    size_t next_background;
+    std::string next_image;
+    uint64_t next_step;
+    sigc::connection enter_fullscreen_conn, leave_fullscreen_conn;
+
+    /* Decoded ahead of time, so that cycling to the next image is instant */
+    BackgroundImageCache::image_t prefetched;
+    bool prefetch_pending = false;
+    /* The cycle timer fired while the next image was still being decoded */
+    bool switch_when_loaded = false;
 
-    WfOption<std::string> background_image{"background/image"};
-    WfOption<int> background_cycle_timeout{"background/cycle_timeout"};
-    WfOption<bool> background_randomize{"background/randomize"};
-    WfOption<bool> background_preserve_aspect{"background/preserve_aspect"};
+    WfOption<std::string> background_image{WfOptions::background::image};
+    WfOption<bool> background_randomize{WfOptions::background::randomize};
+    WfOption<bool> background_preserve_aspect{WfOptions::background::preserve_aspect};
+    WfOption<int> background_memory_budget{WfOptions::background::memory_budget};
+    WfOption<bool> background_span_outputs{WfOptions::background::span_outputs};
+    WfOption<std::string> background_fill{WfOptions::background::fill};
+    WfOption<wf::color_t> background_color{WfOptions::background::color};
+    WfOption<wf::color_t> background_gradient_color{WfOptions::background::gradient_color};
+    WfOption<int> background_gradient_angle{WfOptions::background::gradient_angle};
+    WfOption<int> background_blur_radius{WfOptions::background::blur_radius};
+    WfOption<double> background_dim{WfOptions::background::dim};
 
-    Glib::RefPtr<Gdk::Pixbuf> create_from_file_safe(std::string path);
+    BackgroundImageRequest make_request(const std::string& path);
+    void show_loaded_image(BackgroundImageCache::image_t image);
+    void release_inhibit();
+    bool fits_memory_budget(const BackgroundImageRequest& request);
     bool background_transition_frame(int timer);
-    bool change_background(int timer);
-    bool load_images_from_dir(std::string path);
-    bool load_next_background(Glib::RefPtr<Gdk::Pixbuf> & pbuf, std::string & path);
+    void choose_next_image(uint64_t step);
+    void load_next_background();
+    void prefetch_next_background();
     void reset_background();
     void set_background();
-    void reset_cycle_timeout();
 
+    void update_fill();
+    void handle_fullscreen_changed();
     void setup_window();
 
   public:
-    WayfireBackground(WayfireShellApp *app, WayfireOutput *output);
+    WayfireBackground(WayfireShellApp *app, WayfireOutput *output,
+        BackgroundCycleScheduler *scheduler);
+    ~WayfireBackground();
+
+    /* Called when outputs are added, removed or moved */
+    void handle_layout_changed();
+    /* Switch to the image for the scheduler's current step. Returns false
+     * if the output does not cycle, e.g. because it is fullscreen. */
+    bool change_background();
+    /* Whether the output shows images from a directory with any images */
+    bool has_images() const;
+};
+
+/**
+ * Cycles the backgrounds of all outputs from one clock, instead of a timer
+ * per output. Outputs either switch together in the same main loop
+ * iteration, or one after another with a delay, so that the fades and
+ * surface conversions of several outputs don't happen at the same time.
+ *
+ * Every output shows the image for the current step, so outputs which cycle
+ * through the same images stay in sync and share their decodes through the
+ * image cache. Decodes run one at a time on the worker pool.
+ */
+class BackgroundCycleScheduler
+{
+    std::vector<WayfireBackground*> backgrounds;
+    /* Outputs which have yet to switch in the current staggered cycle */
+    std::vector<WayfireBackground*> pending;
+    uint64_t step = 0;
+    sigc::connection cycle_conn, stagger_conn;
+
+    WfOption<int> background_cycle_timeout{WfOptions::background::cycle_timeout};
+    WfOption<int> background_cycle_stagger{WfOptions::background::cycle_stagger};
+
+    bool cycle();
+    bool switch_next();
+    void reset_cycle_timeout();
+
+  public:
+    BackgroundCycleScheduler();
+    ~BackgroundCycleScheduler();
+
+    void add(WayfireBackground *background);
+    void remove(WayfireBackground *background);
+
+    /* Start or stop the timer, depending on whether any output has images
+     * to cycle through. Called when the images of an output change. */
+    void update_cycle_timeout();
+
+    /* Number of cycles since the start */
+    uint64_t get_step() const;
+};
+
+class WayfireBackgroundApp : public WayfireShellComponent
+{
+    std::map<WayfireOutput*, std::unique_ptr<WayfireBackground>> backgrounds;
+    /* Created once the config has been loaded */
+    std::unique_ptr<BackgroundCycleScheduler> scheduler;
+    WfStatsObject stats{"Background"};
+    /* Connections to the geometry of each output's monitor, which may
+     * outlive the output */
+    std::map<WayfireOutput*, sigc::connection> geometry_conns;
+
+    WayfireBackgroundApp() = default;
+
+  public:
+    ~WayfireBackgroundApp() override;
+
+    /* Adds the background to the shell app */
+    static void create();
+
+    void on_activate() override;
+    void handle_new_output(WayfireOutput *output) override;
+    void handle_output_removed(WayfireOutput *output) override;
+
+    /* Spanned backgrounds depend on the geometry of all outputs */
+    void handle_layout_changed();
 };
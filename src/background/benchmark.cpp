@@ -0,0 +1,278 @@
+/*
+ * Measures the wallpaper pipeline of wf-background without a display:
+ * decoding and scaling images down to the output size, converting them to Cairo
+ * surfaces, the disk cache, and painting the frames of a fade and of a
+ * gradient fill with the painter of the outputs, all on offscreen image
+ * surfaces.
+ *
+ * Run it with `meson test --benchmark`, or directly with the number of fade
+ * frames to paint as the optional argument.
+ */
+
+#include <glibmm/init.h>
+#include <glibmm/fileutils.h>
+#include <glibmm/miscutils.h>
+#include <gdkmm/wrap_init.h>
+#include <cairomm/context.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "image-loader.hpp"
+#include "disk-cache.hpp"
+#include "painter.hpp"
+
+struct resolution_t
+{
+    const char *name;
+    int width, height;
+};
+
+static const std::vector<resolution_t> resolutions = {
+    {"1080p", 1920, 1080},
+    {"1440p", 2560, 1440},
+    {"4K", 3840, 2160},
+};
+
+/* The corpus is larger than the outputs, like most wallpapers, so that
+ * decoding includes scaling down */
+#define SOURCE_SCALE 1.5
+
+static const std::vector<const char*> formats = {"jpeg", "png"};
+
+using bench_clock = std::chrono::steady_clock;
+
+static double elapsed_ms(bench_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(bench_clock::now() - start).count();
+}
+
+/* Reset the peak resident set size of the process to the current one, so
+ * that each row reports its own peak. Returns false if the kernel does not
+ * support it, then the peak of the whole run is reported. */
+static bool reset_peak_rss()
+{
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+    clear_refs.flush();
+    return clear_refs.good();
+}
+
+/* Peak resident set size of the process since the last reset, in MiB */
+static double peak_rss()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+    {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+        {
+            return std::atol(line.c_str() + 6) / 1024.0;
+        }
+    }
+
+    return 0;
+}
+
+/* A smooth gradient with some noise, so that the images compress roughly
+ * like photos instead of collapsing to nothing */
+static Glib::RefPtr<Gdk::Pixbuf> generate_image(int width, int height)
+{
+    auto pbuf = Gdk::Pixbuf::create(Gdk::COLORSPACE_RGB, false, 8, width, height);
+    uint32_t noise = 12345;
+    for (int y = 0; y < height; y++)
+    {
+        guint8 *row = pbuf->get_pixels() + y * pbuf->get_rowstride();
+        for (int x = 0; x < width; x++)
+        {
+            noise = noise * 1103515245 + 12345;
+            int n = (noise >> 16) & 0x1f;
+            row[3 * x]     = std::min(255, 255 * x / width + n);
+            row[3 * x + 1] = std::min(255, 255 * y / height + n);
+            row[3 * x + 2] = std::min(255, (int)(127 + 127 * std::sin(x * 0.01 + y * 0.02)) + n);
+        }
+    }
+
+    return pbuf;
+}
+
+/* Paint the frames of a fade with the painter of the outputs, after
+ * converting both images to the format the target prefers, and return the
+ * average time per frame */
+static double bench_fade(const Cairo::RefPtr<Cairo::ImageSurface>& from,
+    const Cairo::RefPtr<Cairo::ImageSurface>& to, int frames)
+{
+    int width  = to->get_width();
+    int height = to->get_height();
+    auto target = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, width, height);
+    auto cr     = Cairo::Context::create(target);
+    auto create_similar = [=] (Cairo::Content content, int surface_width,
+                                   int surface_height)
+    {
+        return Cairo::Surface::create(target, content, surface_width, surface_height);
+    };
+
+    BackgroundPainter painter;
+    BackgroundImage from_image, to_image;
+    from_image.x = from_image.y = to_image.x = to_image.y = 0;
+    from_image.width  = from->get_width();
+    from_image.height = from->get_height();
+    to_image.width    = width;
+    to_image.height   = height;
+
+    auto start = bench_clock::now();
+    from_image.source = BackgroundPainter::create_native_surface(from, create_similar);
+    to_image.source   = BackgroundPainter::create_native_surface(to, create_similar);
+    for (int i = 0; i < frames; i++)
+    {
+        painter.paint(cr, width, height, to_image, from_image, (double)i / frames);
+    }
+
+    target->flush();
+    return elapsed_ms(start) / frames;
+}
+
+/* Paint a gradient fill, as shown without an image or around images which
+ * don't cover the output, and return the average time per frame */
+static double bench_fill(int width, int height, int frames)
+{
+    auto target = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, width, height);
+    auto cr     = Cairo::Context::create(target);
+
+    BackgroundFill fill;
+    fill.type  = BackgroundFill::LINEAR;
+    fill.color = wf::color_t{0.1, 0.2, 0.4, 1.0};
+    fill.gradient_color = wf::color_t{0.8, 0.5, 0.2, 1.0};
+    fill.angle = 30;
+
+    BackgroundPainter painter;
+    painter.set_fill(fill);
+    BackgroundImage none;
+
+    auto start = bench_clock::now();
+    for (int i = 0; i < frames; i++)
+    {
+        painter.paint(cr, width, height, none, none, 1.0);
+    }
+
+    target->flush();
+    return elapsed_ms(start) / frames;
+}
+
+int main(int argc, char **argv)
+{
+    Glib::init();
+    Gdk::wrap_init();
+
+    int fade_frames = (argc > 1) ? std::max(1, std::atoi(argv[1])) : 60;
+
+    /* Keep the corpus and the disk cache out of the user's directories */
+    gchar *tmp_dir = g_dir_make_tmp("wf-background-benchmark-XXXXXX", nullptr);
+    if (!tmp_dir)
+    {
+        std::cerr << "Failed to create a temporary directory" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::string dir = tmp_dir;
+    g_free(tmp_dir);
+    Glib::setenv("XDG_CACHE_HOME", dir);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "resolution format   decode   convert   cold     warm     fade/frame" <<
+        "  fill/frame  peak RSS" << std::endl;
+
+    std::vector<std::string> files;
+    bool peak_reset_supported = true;
+    for (auto& res : resolutions)
+    {
+        auto source = generate_image(res.width * SOURCE_SCALE, res.height * SOURCE_SCALE);
+        Cairo::RefPtr<Cairo::ImageSurface> previous;
+        for (auto format : formats)
+        {
+            if (peak_reset_supported && !reset_peak_rss())
+            {
+                std::cerr << "Cannot reset the peak RSS, reporting the peak of the run" <<
+                    std::endl;
+                peak_reset_supported = false;
+            }
+
+            auto path = Glib::build_filename(dir,
+                std::string(res.name) + "." + format);
+            source->save(path, format);
+            files.push_back(path);
+
+            BackgroundImageRequest request = {
+                path, res.width, res.height, 1, false, 0, 0.0,
+            };
+
+            /* Decoding and scaling, then the conversion to a surface */
+            auto start     = bench_clock::now();
+            auto animation = BackgroundImageLoader::decode_at_size(request);
+            auto pbuf = animation ? animation->get_static_image() : Glib::RefPtr<Gdk::Pixbuf>();
+            double decode_time = elapsed_ms(start);
+            if (!pbuf)
+            {
+                std::cerr << "Failed to decode " << path << std::endl;
+                return EXIT_FAILURE;
+            }
+
+            start = bench_clock::now();
+            auto surface = pixbuf_to_image_surface(pbuf);
+            double convert_time = elapsed_ms(start);
+            pbuf.reset();
+            animation.reset();
+
+            /* The whole loader path, first storing into the disk cache and
+             * then mapping the stored entry */
+            start = bench_clock::now();
+            BackgroundImageLoader::decode(request);
+            double cold_time = elapsed_ms(start);
+
+            start = bench_clock::now();
+            BackgroundImageLoader::decode(request);
+            double warm_time = elapsed_ms(start);
+
+            double fade_time = bench_fade(previous ? previous : surface, surface, fade_frames);
+            double fill_time = bench_fill(res.width, res.height, fade_frames);
+            previous = surface;
+
+            std::cout << std::left << std::setw(11) << res.name << std::setw(7) << format <<
+                std::right << std::setw(8) << decode_time << " ms" <<
+                std::setw(7) << convert_time << " ms" <<
+                std::setw(7) << cold_time << " ms" <<
+                std::setw(7) << warm_time << " ms" <<
+                std::setw(9) << fade_time << " ms" <<
+                std::setw(9) << fill_time << " ms" <<
+                std::setw(8) << peak_rss() << " MiB" << std::endl;
+        }
+    }
+
+    /* Clean up the corpus and the disk cache entries */
+    std::string cache_dir = Glib::build_filename(dir, "wf-shell", "backgrounds");
+    try {
+        for (auto entry : Glib::Dir(cache_dir))
+        {
+            files.push_back(Glib::build_filename(cache_dir, entry));
+        }
+    } catch (const Glib::FileError&)
+    {}
+
+    for (auto& file : files)
+    {
+        std::remove(file.c_str());
+    }
+
+    std::remove(cache_dir.c_str());
+    std::remove(Glib::build_filename(dir, "wf-shell").c_str());
+    std::remove(dir.c_str());
+    return EXIT_SUCCESS;
+}
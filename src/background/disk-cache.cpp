@@ -0,0 +1,307 @@
+#include <glib.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+#include "disk-cache.hpp"
+
+#define DISK_CACHE_MAGIC    "WFBGRAW"
+#define DISK_CACHE_VERSION  1
+/* Pixel data starts at a multiple of this offset in the file */
+#define DISK_CACHE_ALIGN    64
+/* Least recently used entries are evicted above this total size */
+#define DISK_CACHE_MAX_SIZE (512ul * 1024 * 1024)
+
+namespace
+{
+struct header_t
+{
+    char magic[8];
+    uint32_t version;
+    int32_t width;
+    int32_t height;
+    int32_t stride;
+    /* The full key follows the header, to detect hash collisions */
+    uint32_t key_length;
+};
+
+std::string get_cache_dir()
+{
+    std::string cache_dir;
+
+    char *cache_home = getenv("XDG_CACHE_HOME");
+    if (cache_home == NULL)
+    {
+        cache_dir = std::string(getenv("HOME")) + "/.cache";
+    } else
+    {
+        cache_dir = std::string(cache_home);
+    }
+
+    return cache_dir + "/wf-shell/backgrounds";
+}
+
+/* The key identifies the source file version, the target geometry and the
+ * effects */
+bool get_key(const BackgroundImageRequest& request, std::string& key)
+{
+    struct stat st;
+    if (stat(request.path.c_str(), &st) != 0)
+    {
+        return false;
+    }
+
+    std::ostringstream out;
+    out << request.path << '\n' << st.st_mtim.tv_sec << '.' <<
+        st.st_mtim.tv_nsec << ' ' << st.st_size << ' ' << request.width <<
+        'x' << request.height << '@' << request.scale << ' ' <<
+        request.preserve_aspect << ' ' << request.blur_radius << ' ' <<
+        request.dim;
+    key = out.str();
+    return true;
+}
+
+std::string get_entry_path(const std::string& key)
+{
+    std::ostringstream out;
+    out << get_cache_dir() << "/" << std::hex <<
+        std::hash<std::string>{}(key) << ".raw";
+    return out.str();
+}
+
+size_t get_data_offset(const std::string& key)
+{
+    size_t size = sizeof(header_t) + key.size();
+    return (size + DISK_CACHE_ALIGN - 1) / DISK_CACHE_ALIGN * DISK_CACHE_ALIGN;
+}
+
+struct mapping_t
+{
+    void *data;
+    size_t size;
+};
+
+const cairo_user_data_key_t mapping_key = {};
+void unmap_entry(void *data)
+{
+    auto mapping = static_cast<mapping_t*>(data);
+    munmap(mapping->data, mapping->size);
+    delete mapping;
+}
+
+/* Remove the least recently used entries until the cache fits its budget */
+void prune(const std::string& dir)
+{
+    struct entry_t
+    {
+        std::string path;
+        time_t mtime;
+        off_t size;
+    };
+
+    std::vector<entry_t> entries;
+    size_t total_size = 0;
+
+    auto d = opendir(dir.c_str());
+    if (!d)
+    {
+        return;
+    }
+
+    dirent *file;
+    while ((file = readdir(d)) != 0)
+    {
+        if (file->d_name[0] == '.')
+        {
+            continue;
+        }
+
+        auto fullpath = dir + "/" + file->d_name;
+        struct stat st;
+        if ((stat(fullpath.c_str(), &st) == 0) && S_ISREG(st.st_mode))
+        {
+            entries.push_back({fullpath, st.st_mtime, st.st_size});
+            total_size += st.st_size;
+        }
+    }
+
+    closedir(d);
+    if (total_size <= DISK_CACHE_MAX_SIZE)
+    {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(),
+        [] (const entry_t& a, const entry_t& b) { return a.mtime < b.mtime; });
+    for (auto& entry : entries)
+    {
+        if (total_size <= DISK_CACHE_MAX_SIZE)
+        {
+            break;
+        }
+
+        if (unlink(entry.path.c_str()) == 0)
+        {
+            total_size -= entry.size;
+        }
+    }
+}
+}
+
+Cairo::RefPtr<Cairo::ImageSurface> BackgroundDiskCache::load(
+    const BackgroundImageRequest& request)
+{
+    std::string key;
+    if (!get_key(request, key))
+    {
+        return {};
+    }
+
+    auto path = get_entry_path(key);
+    int fd    = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return {};
+    }
+
+    struct stat st;
+    header_t header;
+    std::string stored_key;
+    size_t data_offset = get_data_offset(key);
+
+    bool valid = (fstat(fd, &st) == 0) &&
+        (read(fd, &header, sizeof(header)) == sizeof(header)) &&
+        !memcmp(header.magic, DISK_CACHE_MAGIC, sizeof(header.magic)) &&
+        (header.version == DISK_CACHE_VERSION) &&
+        (header.key_length == key.size()) &&
+        (header.width > 0) && (header.height > 0) &&
+        (header.stride == cairo_format_stride_for_width(
+            CAIRO_FORMAT_ARGB32, header.width)) &&
+        ((size_t)st.st_size == data_offset + (size_t)header.stride * header.height);
+
+    if (valid)
+    {
+        stored_key.resize(key.size());
+        valid = (read(fd, &stored_key[0], key.size()) == (ssize_t)key.size()) &&
+            (stored_key == key);
+    }
+
+    void *data = MAP_FAILED;
+    if (valid)
+    {
+        /* Private writable mapping: pages are only copied if written to */
+        data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    }
+
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        return {};
+    }
+
+    auto surface = Cairo::ImageSurface::create((unsigned char*)data + data_offset,
+        Cairo::FORMAT_ARGB32, header.width, header.height, header.stride);
+    auto mapping = new mapping_t{data, (size_t)st.st_size};
+    cairo_surface_set_user_data(surface->cobj(), &mapping_key, mapping, unmap_entry);
+
+    /* Mark the entry as recently used */
+    utimensat(AT_FDCWD, path.c_str(), NULL, 0);
+    return surface;
+}
+
+void BackgroundDiskCache::store(const BackgroundImageRequest& request,
+    const Cairo::RefPtr<Cairo::ImageSurface>& surface)
+{
+    std::string key;
+    if (!surface || (surface->get_format() != Cairo::FORMAT_ARGB32) ||
+        !get_key(request, key))
+    {
+        return;
+    }
+
+    auto dir = get_cache_dir();
+    if (g_mkdir_with_parents(dir.c_str(), 0700) != 0)
+    {
+        return;
+    }
+
+    header_t header = {};
+    strcpy(header.magic, DISK_CACHE_MAGIC);
+    header.version    = DISK_CACHE_VERSION;
+    header.width      = surface->get_width();
+    header.height     = surface->get_height();
+    header.stride     = surface->get_stride();
+    header.key_length = key.size();
+
+    /* Write to a temporary file first, so that concurrent readers never
+     * see a partially written entry */
+    auto path     = get_entry_path(key);
+    auto tmp_path = path + ".XXXXXX";
+    int fd = mkostemp(&tmp_path[0], O_CLOEXEC);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    std::string prefix((char*)&header, sizeof(header));
+    prefix += key;
+    prefix.resize(get_data_offset(key), '\0');
+
+    surface->flush();
+    size_t data_size = (size_t)header.stride * header.height;
+    bool ok = (write(fd, prefix.data(), prefix.size()) == (ssize_t)prefix.size()) &&
+        (write(fd, surface->get_data(), data_size) == (ssize_t)data_size);
+    close(fd);
+
+    if (!ok || (rename(tmp_path.c_str(), path.c_str()) != 0))
+    {
+        unlink(tmp_path.c_str());
+        return;
+    }
+
+    prune(dir);
+}
+
+Cairo::RefPtr<Cairo::ImageSurface> pixbuf_to_image_surface(
+    const Glib::RefPtr<Gdk::Pixbuf>& pbuf)
+{
+    int width      = pbuf->get_width();
+    int height     = pbuf->get_height();
+    int channels   = pbuf->get_n_channels();
+    int src_stride = pbuf->get_rowstride();
+    const guint8 *src_data = pbuf->get_pixels();
+
+    auto surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, width, height);
+    int dst_stride = surface->get_stride();
+    unsigned char *dst_data = surface->get_data();
+
+    for (int j = 0; j < height; j++)
+    {
+        const guint8 *src = src_data + j * src_stride;
+        auto dst = (uint32_t*)(dst_data + j * dst_stride);
+        for (int i = 0; i < width; i++, src += channels)
+        {
+            uint32_t a = (channels == 4) ? src[3] : 0xff;
+            uint32_t r = src[0], g = src[1], b = src[2];
+            if (a != 0xff)
+            {
+                /* Premultiply with rounding, like gdk_cairo does */
+                r = (r * a + 0x80) * 0x101 >> 16;
+                g = (g * a + 0x80) * 0x101 >> 16;
+                b = (b * a + 0x80) * 0x101 >> 16;
+            }
+
+            dst[i] = (a << 24) | (r << 16) | (g << 8) | b;
+        }
+    }
+
+    surface->mark_dirty();
+    return surface;
+}
@@ -0,0 +1,35 @@
+#ifndef WF_BACKGROUND_DISK_CACHE_HPP
+#define WF_BACKGROUND_DISK_CACHE_HPP
+
+#include <cairomm/surface.h>
+#include <gdkmm/pixbuf.h>
+
+#include "image-loader.hpp"
+
+/**
+ * A persistent cache of wallpapers which have already been scaled to the
+ * size of an output, stored in $XDG_CACHE_HOME/wf-shell/backgrounds.
+ *
+ * Entries are stored as raw premultiplied ARGB32 data, so that they can be
+ * mapped directly into a Cairo image surface without decoding. They are
+ * keyed by the source path, its mtime and size, and the requested geometry,
+ * so changing the source file invalidates its entries.
+ *
+ * All functions are safe to call from the worker pool.
+ */
+namespace BackgroundDiskCache
+{
+/* Returns the cached surface for the request, or null on a cache miss */
+Cairo::RefPtr<Cairo::ImageSurface> load(const BackgroundImageRequest& request);
+
+/* Store the surface for the request, evicting old entries if necessary */
+void store(const BackgroundImageRequest& request,
+    const Cairo::RefPtr<Cairo::ImageSurface>& surface);
+}
+
+/* Convert the pixbuf to a premultiplied ARGB32 image surface without touching
+ * GDK, so it can be used from worker threads */
+Cairo::RefPtr<Cairo::ImageSurface> pixbuf_to_image_surface(
+    const Glib::RefPtr<Gdk::Pixbuf>& pbuf);
+
+#endif /* end of include guard: WF_BACKGROUND_DISK_CACHE_HPP */
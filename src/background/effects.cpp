@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "effects.hpp"
+
+/* Number of box blur passes in each direction */
+#define BLUR_PASSES 3
+
+namespace
+{
+/*
+ * One box blur pass along the columns of an image of rows_bytes x height
+ * bytes, with edge pixels repeated. Each byte is treated as an independent
+ * channel, so the inner loops run over whole rows of bytes with no
+ * dependencies between iterations and are vectorized by the compiler.
+ * Rows are blurred by transposing the image and blurring its columns.
+ */
+void box_blur_columns(const uint8_t *src, uint8_t *dst, size_t row_bytes,
+    int height, size_t stride, int radius, std::vector<uint32_t>& acc)
+{
+    const uint32_t window = 2 * radius + 1;
+    /* Fixed point reciprocal, rounded up so that a window of 255s stays 255,
+     * acc * mul stays below 2^32 */
+    const uint32_t mul = ((1u << 24) + window - 1) / window;
+    auto row = [&] (int y)
+    {
+        return src + std::min(std::max(y, 0), height - 1) * stride;
+    };
+
+    acc.assign(row_bytes, 0);
+    uint32_t *sum = acc.data();
+    for (int k = -radius; k <= radius; k++)
+    {
+        const uint8_t *in = row(k);
+        for (size_t i = 0; i < row_bytes; i++)
+        {
+            sum[i] += in[i];
+        }
+    }
+
+    for (int y = 0; y < height; y++)
+    {
+        uint8_t *out = dst + y * stride;
+        for (size_t i = 0; i < row_bytes; i++)
+        {
+            out[i] = (sum[i] * mul) >> 24;
+        }
+
+        const uint8_t *add = row(y + radius + 1);
+        const uint8_t *sub = row(y - radius);
+        for (size_t i = 0; i < row_bytes; i++)
+        {
+            sum[i] += add[i] - sub[i];
+        }
+    }
+}
+
+/* Transpose width x height pixels, in blocks to stay cache friendly */
+void transpose(const uint32_t *src, uint32_t *dst, int width, int height,
+    size_t src_stride, size_t dst_stride)
+{
+    const int block = 16;
+    for (int by = 0; by < height; by += block)
+    {
+        for (int bx = 0; bx < width; bx += block)
+        {
+            int ey = std::min(by + block, height);
+            int ex = std::min(bx + block, width);
+            for (int y = by; y < ey; y++)
+            {
+                for (int x = bx; x < ex; x++)
+                {
+                    dst[x * dst_stride + y] = src[y * src_stride + x];
+                }
+            }
+        }
+    }
+}
+
+/* Run the column passes, ping-ponging between buf and tmp. An odd number of
+ * passes leaves the result in tmp. */
+void blur_columns(uint32_t *buf, uint32_t *tmp, int width, int height,
+    int radius, std::vector<uint32_t>& acc)
+{
+    size_t row_bytes = width * 4;
+    for (int pass = 0; pass < BLUR_PASSES; pass++)
+    {
+        auto src = (pass % 2) ? tmp : buf;
+        auto dst = (pass % 2) ? buf : tmp;
+        box_blur_columns((uint8_t*)src, (uint8_t*)dst, row_bytes, height,
+            row_bytes, radius, acc);
+    }
+}
+}
+
+void blur_image_surface(const Cairo::RefPtr<Cairo::ImageSurface>& surface, int radius)
+{
+    if ((radius <= 0) || (surface->get_format() != Cairo::FORMAT_ARGB32))
+    {
+        return;
+    }
+
+    surface->flush();
+    int width  = surface->get_width();
+    int height = surface->get_height();
+    int stride = surface->get_stride() / 4;
+    auto data  = (uint32_t*)surface->get_data();
+
+    static_assert(BLUR_PASSES % 2 == 1, "The passes must end in the temporary buffer");
+    std::vector<uint32_t> a((size_t)width * height), b((size_t)width * height);
+    std::vector<uint32_t> acc;
+
+    /* Vertical passes on a tightly packed copy of the image */
+    for (int y = 0; y < height; y++)
+    {
+        std::memcpy(&a[(size_t)y * width], data + (size_t)y * stride, width * 4);
+    }
+
+    blur_columns(a.data(), b.data(), width, height, radius, acc);
+
+    /* Horizontal passes, as vertical passes on the transposed image */
+    transpose(b.data(), a.data(), width, height, width, height);
+    blur_columns(a.data(), b.data(), height, width, radius, acc);
+    transpose(b.data(), data, height, width, height, stride);
+
+    surface->mark_dirty();
+}
+
+void dim_image_surface(const Cairo::RefPtr<Cairo::ImageSurface>& surface, double dim)
+{
+    if ((dim <= 0) || (surface->get_format() != Cairo::FORMAT_ARGB32))
+    {
+        return;
+    }
+
+    surface->flush();
+    int width  = surface->get_width();
+    int height = surface->get_height();
+    int stride = surface->get_stride();
+    auto data  = surface->get_data();
+
+    /* The data is premultiplied, so darkening only scales the color
+     * channels, alpha is kept */
+    const uint32_t factor = (1.0 - std::min(dim, 1.0)) * 256;
+    for (int y = 0; y < height; y++)
+    {
+        auto row = (uint32_t*)(data + y * stride);
+        for (int x = 0; x < width; x++)
+        {
+            uint32_t p  = row[x];
+            uint32_t rb = (((p & 0x00ff00ff) * factor) >> 8) & 0x00ff00ff;
+            uint32_t g  = (((p & 0x0000ff00) * factor) >> 8) & 0x0000ff00;
+            row[x] = (p & 0xff000000) | rb | g;
+        }
+    }
+
+    surface->mark_dirty();
+}
@@ -0,0 +1,19 @@
+#ifndef WF_BACKGROUND_EFFECTS_HPP
+#define WF_BACKGROUND_EFFECTS_HPP
+
+#include <cairomm/surface.h>
+
+/**
+ * Effects which are applied once to a decoded wallpaper, before it is cached.
+ * They work in place on premultiplied ARGB32 image surfaces and are safe to
+ * call from worker threads.
+ */
+
+/* Blur the surface with three box blur passes in each direction, which
+ * closely approximate a Gaussian blur. The radius is in surface pixels. */
+void blur_image_surface(const Cairo::RefPtr<Cairo::ImageSurface>& surface, int radius);
+
+/* Darken the surface, dim is between 0 (unchanged) and 1 (black) */
+void dim_image_surface(const Cairo::RefPtr<Cairo::ImageSurface>& surface, double dim);
+
+#endif /* end of include guard: WF_BACKGROUND_EFFECTS_HPP */
@@ -0,0 +1,134 @@
+#include <cmath>
+
+#include "image-cache.hpp"
+
+std::weak_ptr<BackgroundImageCache> BackgroundImageCache::instance;
+
+std::shared_ptr<BackgroundImageCache> BackgroundImageCache::Launch()
+{
+    if (instance.expired())
+    {
+        auto new_instance = std::shared_ptr<BackgroundImageCache>(
+            new BackgroundImageCache());
+        instance = new_instance;
+        return new_instance;
+    }
+
+    return instance.lock();
+}
+
+BackgroundImageCache::image_t BackgroundImageCache::lookup(
+    const BackgroundImageRequest& request)
+{
+    auto it = images.find(request);
+    if (it == images.end())
+    {
+        return nullptr;
+    }
+
+    auto image = it->second.lock();
+    if (!image)
+    {
+        images.erase(it);
+    }
+
+    return image;
+}
+
+BackgroundImageCache::image_t BackgroundImageCache::insert(
+    const BackgroundImageRequest& request, const BackgroundImageLoader::frames_t& frames)
+{
+    auto image = std::make_shared<BackgroundCachedImage>();
+    image->request     = request;
+    image->source      = frames.front().surface;
+    image->memory_size = 0;
+    if (frames.size() > 1)
+    {
+        image->frames = frames;
+    }
+
+    /* Frames of large animations may have fewer pixels than the output.
+     * The device scale is set from the loader's values rather than from the
+     * surface, since the surfaces may already have been inserted for
+     * another request. */
+    for (auto& frame : frames)
+    {
+        auto& surface = frame.surface;
+        cairo_surface_set_device_scale(surface->cobj(),
+            frame.scale_x * request.scale, frame.scale_y * request.scale);
+        image->memory_size += (size_t)surface->get_stride() * surface->get_height();
+    }
+
+    auto& front   = frames.front();
+    double width  = front.surface->get_width() / front.scale_x;
+    double height = front.surface->get_height() / front.scale_y;
+    image->offset_x = image->offset_y = 0.0;
+    if (request.preserve_aspect)
+    {
+        bool eq_width = (std::abs(request.width - width) < 1);
+        image->offset_x = eq_width ? 0 : (request.width - width) * 0.5;
+        image->offset_y = eq_width ? (request.height - height) * 0.5 : 0;
+    }
+
+    /* Drop entries whose images are no longer used by any output */
+    for (auto it = images.begin(); it != images.end();)
+    {
+        it = it->second.expired() ? images.erase(it) : std::next(it);
+    }
+
+    images[request] = image;
+    return image;
+}
+
+size_t BackgroundImageCache::memory_usage()
+{
+    size_t usage = 0;
+    for (auto it = images.begin(); it != images.end();)
+    {
+        if (auto image = it->second.lock())
+        {
+            usage += image->memory_size;
+            ++it;
+        } else
+        {
+            it = images.erase(it);
+        }
+    }
+
+    return usage;
+}
+
+void BackgroundImageCache::load(const BackgroundImageRequest& request,
+    const void *owner, callback_t callback)
+{
+    if (auto image = lookup(request))
+    {
+        callback(request, image);
+        return;
+    }
+
+    loader.load(request, owner, [=] (const BackgroundImageRequest& request,
+                                     const BackgroundImageLoader::frames_t& frames)
+    {
+        if (frames.empty())
+        {
+            callback(request, nullptr);
+            return;
+        }
+
+        /* The first output to receive the decoded image converts it, the
+         * others waiting for the same decode reuse the result. */
+        auto image = lookup(request);
+        callback(request, image ? image : insert(request, frames));
+    });
+}
+
+void BackgroundImageCache::cancel(const void *owner)
+{
+    loader.cancel(owner);
+}
+
+bool BackgroundImageCache::busy(const void *owner) const
+{
+    return loader.busy(owner);
+}
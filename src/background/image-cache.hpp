@@ -0,0 +1,81 @@
+#ifndef WF_BACKGROUND_IMAGE_CACHE_HPP
+#define WF_BACKGROUND_IMAGE_CACHE_HPP
+
+#include <cairomm/surface.h>
+#include <functional>
+#include <memory>
+#include <map>
+
+#include "image-loader.hpp"
+
+/**
+ * A wallpaper which has been decoded and scaled for a particular output
+ * geometry. It is shared between all outputs which request the same image
+ * with the same geometry.
+ */
+struct BackgroundCachedImage
+{
+    BackgroundImageRequest request;
+    /* The image, or the first frame of animations */
+    Cairo::RefPtr<Cairo::Surface> source;
+    /* All frames of animations, empty for still images */
+    BackgroundImageLoader::frames_t frames;
+    /* Offsets of the image inside the output, in physical pixels */
+    double offset_x, offset_y;
+    /* Size of the pixel data of all frames in bytes */
+    size_t memory_size;
+};
+
+/**
+ * A process-wide cache of decoded wallpapers.
+ *
+ * Images are reference-counted: an entry stays in the cache for as long as
+ * at least one output holds a pointer to it, and identical requests which
+ * arrive while the image is being decoded share a single decode.
+ */
+class BackgroundImageCache
+{
+  public:
+    using image_t    = std::shared_ptr<BackgroundCachedImage>;
+    /* Called on the main loop. The image is null if it failed to load */
+    using callback_t = std::function<void (const BackgroundImageRequest&, image_t)>;
+
+    /**
+     * Returns the cache instance, creating it if necessary.
+     * Once there are no alive shared pointers to the instance, the cache
+     * is destroyed.
+     */
+    static std::shared_ptr<BackgroundImageCache> Launch();
+
+    /**
+     * Get the image for the given request. If it is already cached, the
+     * callback is called immediately, otherwise after the image has been
+     * decoded.
+     */
+    void load(const BackgroundImageRequest& request, const void *owner,
+        callback_t callback);
+
+    /* Make sure none of the callbacks queued by owner will be called */
+    void cancel(const void *owner);
+
+    /* Whether owner is waiting for an image to be decoded */
+    bool busy(const void *owner) const;
+
+    /* Returns the cached image, or null if no output uses it */
+    image_t lookup(const BackgroundImageRequest& request);
+
+    /* Total size in bytes of the images which are currently alive */
+    size_t memory_usage();
+
+  private:
+    BackgroundImageCache() = default;
+    static std::weak_ptr<BackgroundImageCache> instance;
+
+    std::map<BackgroundImageRequest, std::weak_ptr<BackgroundCachedImage>> images;
+    BackgroundImageLoader loader;
+
+    image_t insert(const BackgroundImageRequest& request,
+        const BackgroundImageLoader::frames_t& frames);
+};
+
+#endif /* end of include guard: WF_BACKGROUND_IMAGE_CACHE_HPP */
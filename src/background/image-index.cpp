@@ -0,0 +1,298 @@
+#include <glibmm/main.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <wordexp.h>
+#include <unistd.h>
+
+#include "image-index.hpp"
+
+#define INOT_BUF_SIZE (1024 * (sizeof(inotify_event) + 16))
+#define INOT_DIR_MASK (IN_CREATE | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | \
+    IN_MOVED_TO | IN_ONLYDIR)
+
+std::map<std::string, std::weak_ptr<BackgroundImageIndex>> BackgroundImageIndex::instances;
+
+std::shared_ptr<BackgroundImageIndex> BackgroundImageIndex::Launch(const std::string& path)
+{
+    wordexp_t exp;
+
+    /* Expand path */
+    if (wordexp(path.c_str(), &exp, 0))
+    {
+        return nullptr;
+    }
+
+    if (!exp.we_wordc)
+    {
+        wordfree(&exp);
+        return nullptr;
+    }
+
+    std::string root = exp.we_wordv[0];
+    wordfree(&exp);
+
+    if (auto index = instances[root].lock())
+    {
+        return index;
+    }
+
+    struct stat st;
+    if ((stat(root.c_str(), &st) != 0) || !S_ISDIR(st.st_mode))
+    {
+        instances.erase(root);
+        return nullptr;
+    }
+
+    auto index = std::shared_ptr<BackgroundImageIndex>(new BackgroundImageIndex(root));
+    instances[root] = index;
+    return index;
+}
+
+BackgroundImageIndex::BackgroundImageIndex(const std::string& root)
+{
+    this->root = root;
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd >= 0)
+    {
+        inotify_conn = Glib::signal_io().connect(
+            [=] (Glib::IOCondition) { return handle_inotify_events(); },
+            inotify_fd, Glib::IO_IN | Glib::IO_HUP);
+    }
+
+    scan_dir(root);
+}
+
+BackgroundImageIndex::~BackgroundImageIndex()
+{
+    inotify_conn.disconnect();
+    if (inotify_fd >= 0)
+    {
+        close(inotify_fd);
+    }
+
+    auto it = instances.find(root);
+    if ((it != instances.end()) && it->second.expired())
+    {
+        instances.erase(it);
+    }
+}
+
+size_t BackgroundImageIndex::size() const
+{
+    return images.size();
+}
+
+const std::string& BackgroundImageIndex::at(size_t position) const
+{
+    return images[position];
+}
+
+bool BackgroundImageIndex::contains(const std::string& image) const
+{
+    return positions.count(image);
+}
+
+size_t BackgroundImageIndex::random_position()
+{
+    return std::uniform_int_distribution<size_t>(0, images.size() - 1)(random_gen);
+}
+
+size_t BackgroundImageIndex::shuffled_position(uint64_t step) const
+{
+    /* splitmix64 */
+    uint64_t z = shuffle_seed + step * 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return (z ^ (z >> 31)) % images.size();
+}
+
+sigc::signal<void()> BackgroundImageIndex::signal_changed()
+{
+    return changed;
+}
+
+void BackgroundImageIndex::add(const std::string& image)
+{
+    if (positions.count(image))
+    {
+        return;
+    }
+
+    positions[image] = images.size();
+    images.push_back(image);
+}
+
+void BackgroundImageIndex::remove(const std::string& image)
+{
+    auto it = positions.find(image);
+    if (it == positions.end())
+    {
+        return;
+    }
+
+    /* Move the last image into the freed slot */
+    size_t position = it->second;
+    positions.erase(it);
+    if (position != images.size() - 1)
+    {
+        images[position] = std::move(images.back());
+        positions[images[position]] = position;
+    }
+
+    images.pop_back();
+}
+
+void BackgroundImageIndex::scan_dir(const std::string& dir)
+{
+    auto d = opendir(dir.c_str());
+    if (!d)
+    {
+        return;
+    }
+
+    if (inotify_fd >= 0)
+    {
+        int wd = inotify_add_watch(inotify_fd, dir.c_str(), INOT_DIR_MASK);
+        if (wd >= 0)
+        {
+            watched_dirs[wd] = dir;
+        }
+    }
+
+    /* Iterate over all files in the directory */
+    dirent *file;
+    while ((file = readdir(d)) != 0)
+    {
+        /* Skip hidden files and folders */
+        if (file->d_name[0] == '.')
+        {
+            continue;
+        }
+
+        auto fullpath = dir + "/" + file->d_name;
+
+        struct stat next;
+        if (stat(fullpath.c_str(), &next) == 0)
+        {
+            if (S_ISDIR(next.st_mode))
+            {
+                /* Recursive search */
+                scan_dir(fullpath);
+            } else
+            {
+                add(fullpath);
+            }
+        }
+    }
+
+    closedir(d);
+}
+
+void BackgroundImageIndex::remove_dir(const std::string& dir)
+{
+    auto prefix = dir + "/";
+    auto in_dir = [&] (const std::string& path)
+    {
+        return (path == dir) || !path.compare(0, prefix.size(), prefix);
+    };
+
+    for (size_t i = 0; i < images.size();)
+    {
+        if (in_dir(images[i]))
+        {
+            /* The last image is moved to position i, so check it again */
+            remove(images[i]);
+        } else
+        {
+            ++i;
+        }
+    }
+
+    /* Watches on deleted directories are removed automatically, but not on
+     * directories which have been moved elsewhere */
+    for (auto it = watched_dirs.begin(); it != watched_dirs.end();)
+    {
+        if (in_dir(it->second))
+        {
+            inotify_rm_watch(inotify_fd, it->first);
+            it = watched_dirs.erase(it);
+        } else
+        {
+            ++it;
+        }
+    }
+}
+
+bool BackgroundImageIndex::handle_inotify_events()
+{
+    alignas(inotify_event) char buf[INOT_BUF_SIZE];
+    bool was_changed = false;
+
+    ssize_t len;
+    while ((len = read(inotify_fd, buf, sizeof(buf))) > 0)
+    {
+        const inotify_event *event;
+        for (char *ptr = buf; ptr < buf + len; ptr += sizeof(inotify_event) + event->len)
+        {
+            event = (const inotify_event*)ptr;
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                /* We lost track of the changes, start over */
+                for (auto& dir : watched_dirs)
+                {
+                    inotify_rm_watch(inotify_fd, dir.first);
+                }
+
+                watched_dirs.clear();
+                images.clear();
+                positions.clear();
+                scan_dir(root);
+                was_changed = true;
+                continue;
+            }
+
+            if (event->mask & IN_IGNORED)
+            {
+                watched_dirs.erase(event->wd);
+                continue;
+            }
+
+            auto dir = watched_dirs.find(event->wd);
+            if ((dir == watched_dirs.end()) || !event->len || (event->name[0] == '.'))
+            {
+                continue;
+            }
+
+            auto fullpath = dir->second + "/" + event->name;
+            if (event->mask & IN_ISDIR)
+            {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO))
+                {
+                    scan_dir(fullpath);
+                } else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+                {
+                    remove_dir(fullpath);
+                }
+            } else
+            {
+                if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+                {
+                    add(fullpath);
+                } else if (event->mask & (IN_DELETE | IN_MOVED_FROM))
+                {
+                    remove(fullpath);
+                }
+            }
+
+            was_changed = true;
+        }
+    }
+
+    if (was_changed)
+    {
+        changed.emit();
+    }
+
+    return true;
+}
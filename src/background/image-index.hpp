@@ -0,0 +1,71 @@
+#ifndef WF_BACKGROUND_IMAGE_INDEX_HPP
+#define WF_BACKGROUND_IMAGE_INDEX_HPP
+
+#include <sigc++/sigc++.h>
+
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * An index of the images in a wallpaper directory and its subdirectories.
+ *
+ * The directory is scanned once, and afterwards the index is kept up to date
+ * with inotify, so large collections are not walked again when the
+ * background is reloaded. Looking up an image by position, picking a random
+ * image and removing an image are all O(1).
+ */
+class BackgroundImageIndex
+{
+  public:
+    /**
+     * Returns the index of the given directory, which is shared with other
+     * users of the same directory. The path is expanded like in a shell.
+     *
+     * Returns null if the path is not a directory.
+     */
+    static std::shared_ptr<BackgroundImageIndex> Launch(const std::string& path);
+    ~BackgroundImageIndex();
+
+    size_t size() const;
+    const std::string& at(size_t position) const;
+    bool contains(const std::string& image) const;
+    /* Returns a uniformly distributed position, the index must not be empty */
+    size_t random_position();
+    /* Returns the position at the given step of a pseudo-random sequence
+     * which is the same for all users of the index */
+    size_t shuffled_position(uint64_t step) const;
+
+    /* Remove an image, for example because it failed to load.
+     * It will be added back if the file is modified. */
+    void remove(const std::string& image);
+
+    /* Emitted when images are added or removed because of filesystem changes */
+    sigc::signal<void()> signal_changed();
+
+  private:
+    BackgroundImageIndex(const std::string& root);
+    static std::map<std::string, std::weak_ptr<BackgroundImageIndex>> instances;
+
+    std::string root;
+    std::vector<std::string> images;
+    /* Position of each image in the images vector */
+    std::unordered_map<std::string, size_t> positions;
+    std::mt19937 random_gen{std::random_device{}()};
+    uint64_t shuffle_seed = std::random_device{}();
+
+    int inotify_fd = -1;
+    std::unordered_map<int, std::string> watched_dirs;
+    sigc::connection inotify_conn;
+    sigc::signal<void()> changed;
+
+    void add(const std::string& image);
+    void scan_dir(const std::string& dir);
+    void remove_dir(const std::string& dir);
+    bool handle_inotify_events();
+};
+
+#endif /* end of include guard: WF_BACKGROUND_IMAGE_INDEX_HPP */
@@ -0,0 +1,380 @@
+#include <gdkmm/pixbufloader.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "image-loader.hpp"
+#include "disk-cache.hpp"
+#include "effects.hpp"
+
+/* Size of the chunks in which image files are fed to the pixbuf loader */
+#define DECODE_CHUNK_SIZE (64 * 1024)
+/* Memory which the frames of one animation may use at most */
+#define ANIMATION_MEMORY_LIMIT (256 * 1024 * 1024)
+#define ANIMATION_MAX_FRAMES 1024
+/* Shortest frame delay in milliseconds, like browsers do for GIFs with
+ * delays of 0 */
+#define ANIMATION_MIN_DELAY 20
+
+/* Size of an image of the given size after scaling it for the request */
+static void get_target_size(const BackgroundImageRequest& request,
+    int width, int height, int& target_width, int& target_height)
+{
+    target_width  = request.width;
+    target_height = request.height;
+    if (request.preserve_aspect)
+    {
+        if ((double)height * request.width > (double)width * request.height)
+        {
+            target_width = 0.5 + (double)width * request.height / height;
+        } else
+        {
+            target_height = 0.5 + (double)height * request.width / width;
+        }
+    }
+
+    target_width  = std::max(target_width, 1);
+    target_height = std::max(target_height, 1);
+}
+
+/* FNV-1a hash of the pixels, used to find where an animation loops. Rows
+ * are hashed a word at a time, since every frame of the walk is hashed. */
+static uint64_t hash_pixbuf(const Glib::RefPtr<Gdk::Pixbuf>& pbuf)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    int row_size  = pbuf->get_width() * pbuf->get_n_channels();
+    for (int y = 0; y < pbuf->get_height(); y++)
+    {
+        const guint8 *row = pbuf->get_pixels() + y * pbuf->get_rowstride();
+        int i = 0;
+        for (; i + 8 <= row_size; i += 8)
+        {
+            uint64_t word;
+            memcpy(&word, row + i, sizeof(word));
+            hash = (hash ^ word) * 0x100000001b3ull;
+        }
+
+        for (; i < row_size; i++)
+        {
+            hash = (hash ^ row[i]) * 0x100000001b3ull;
+        }
+    }
+
+    return hash;
+}
+
+/* The shortest period of the whole sequence, computed from its prefix
+ * function. Periods which were not seen at least twice are not trusted, then
+ * the length of the sequence is returned. */
+template<class T>
+static size_t find_period(const std::vector<T>& sequence)
+{
+    size_t n = sequence.size();
+    if (n < 2)
+    {
+        return n;
+    }
+
+    std::vector<size_t> prefix(n, 0);
+    for (size_t i = 1; i < n; i++)
+    {
+        size_t k = prefix[i - 1];
+        while ((k > 0) && (sequence[i] != sequence[k]))
+        {
+            k = prefix[k - 1];
+        }
+
+        prefix[i] = (sequence[i] == sequence[k]) ? k + 1 : k;
+    }
+
+    size_t period = n - prefix[n - 1];
+    return (2 * period <= n) ? period : n;
+}
+
+/* GdkPixbufAnimationIter only takes the deprecated GTimeVal, so times are
+ * kept in microseconds and only converted here */
+G_GNUC_BEGIN_IGNORE_DEPRECATIONS
+static Glib::RefPtr<Gdk::PixbufAnimationIter> get_animation_iter(
+    const Glib::RefPtr<Gdk::PixbufAnimation>& animation)
+{
+    GTimeVal start = {0, 0};
+    return Glib::wrap(gdk_pixbuf_animation_get_iter(animation->gobj(), &start));
+}
+
+static void advance_animation_iter(const Glib::RefPtr<Gdk::PixbufAnimationIter>& iter,
+    gint64 time)
+{
+    GTimeVal current;
+    current.tv_sec  = time / G_USEC_PER_SEC;
+    current.tv_usec = time % G_USEC_PER_SEC;
+    gdk_pixbuf_animation_iter_advance(iter->gobj(), &current);
+}
+
+G_GNUC_END_IGNORE_DEPRECATIONS
+
+BackgroundImageLoader::frames_t BackgroundImageLoader::decode(
+    const BackgroundImageRequest& request)
+{
+    if (auto surface = BackgroundDiskCache::load(request))
+    {
+        return {{surface, -1}};
+    }
+
+    auto animation = decode_at_size(request);
+    if (!animation)
+    {
+        return {};
+    }
+
+    if (!animation->is_static_image())
+    {
+        return decode_animation(request, animation);
+    }
+
+    auto pbuf = animation->get_static_image();
+    if (!pbuf)
+    {
+        return {};
+    }
+
+    auto surface = pixbuf_to_image_surface(pbuf);
+    /* Don't keep the pixbuf alive while writing the disk cache */
+    pbuf.reset();
+    animation.reset();
+    /* Effects are applied once per decode, so the cached result can be
+     * painted as is on every frame */
+    blur_image_surface(surface, request.blur_radius);
+    dim_image_surface(surface, request.dim);
+    BackgroundDiskCache::store(request, surface);
+    return {{surface, -1}};
+}
+
+BackgroundImageLoader::frames_t BackgroundImageLoader::decode_animation(
+    const BackgroundImageRequest& request,
+    const Glib::RefPtr<Gdk::PixbufAnimation>& animation)
+{
+    /* GdkPixbufAnimation does not tell how many frames a loop has, or how
+     * long it is. Step through the animation until it stops or the frame
+     * limit is reached, and take the loop from the period of the whole walk,
+     * so that repeated frames at the start don't cut the loop short. Only
+     * hashes are kept in this pass. */
+    std::vector<std::pair<uint64_t, int>> sequence;
+    gint64 time = 0;
+    auto iter   = get_animation_iter(animation);
+    while (sequence.size() < ANIMATION_MAX_FRAMES)
+    {
+        int delay = iter->get_delay_time();
+        if (delay >= 0)
+        {
+            delay = std::max(delay, ANIMATION_MIN_DELAY);
+        }
+
+        sequence.push_back({hash_pixbuf(iter->get_pixbuf()), delay});
+        if (delay < 0)
+        {
+            /* The animation stops at this frame */
+            break;
+        }
+
+        time += delay * 1000;
+        advance_animation_iter(iter, time);
+    }
+
+    size_t loop_length = (sequence.back().second < 0) ?
+        sequence.size() : find_period(sequence);
+
+    /* Lower the resolution of all frames if the loop would not fit */
+    int width, height;
+    get_target_size(request, animation->get_width(), animation->get_height(),
+        width, height);
+    double needed = (double)width * height * 4 * loop_length;
+    double factor = std::min(1.0, std::sqrt(ANIMATION_MEMORY_LIMIT / needed));
+    int frame_width  = std::max(1, (int)(width * factor));
+    int frame_height = std::max(1, (int)(height * factor));
+
+    frames_t frames;
+    time = 0;
+    iter = get_animation_iter(animation);
+    for (size_t i = 0; i < loop_length; i++)
+    {
+        auto pbuf = iter->get_pixbuf()->scale_simple(frame_width, frame_height,
+            Gdk::INTERP_BILINEAR);
+        if (!pbuf)
+        {
+            return {};
+        }
+
+        auto surface = pixbuf_to_image_surface(pbuf);
+        blur_image_surface(surface, request.blur_radius * factor);
+        dim_image_surface(surface, request.dim);
+
+        int delay = sequence[i].second;
+        frames.push_back({surface, (delay < 0) ? -1 : delay,
+            (double)frame_width / width, (double)frame_height / height});
+        if (delay >= 0)
+        {
+            time += delay * 1000;
+            advance_animation_iter(iter, time);
+        }
+    }
+
+    return frames;
+}
+
+Glib::RefPtr<Gdk::PixbufAnimation> BackgroundImageLoader::decode_at_size(
+    const BackgroundImageRequest& request)
+{
+    int fd = open(request.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return {};
+    }
+
+    Glib::RefPtr<Gdk::PixbufAnimation> animation;
+    try {
+        auto loader = Gdk::PixbufLoader::create();
+
+        /* Setting the size before any pixel data arrives lets loaders which
+         * support it decode at a reduced size directly, e.g. the JPEG loader
+         * uses libjpeg's DCT scaling. Then the full resolution image is never
+         * held in memory. */
+        loader->signal_size_prepared().connect([&] (int width, int height)
+        {
+            int target_width, target_height;
+            get_target_size(request, width, height, target_width, target_height);
+            loader->set_size(target_width, target_height);
+        });
+
+        guint8 buf[DECODE_CHUNK_SIZE];
+        ssize_t len;
+        while ((len = read(fd, buf, sizeof(buf))) > 0)
+        {
+            loader->write(buf, len);
+        }
+
+        loader->close();
+        if (len == 0)
+        {
+            animation = loader->get_animation();
+        }
+    } catch (...)
+    {
+        animation.reset();
+    }
+
+    close(fd);
+    return animation;
+}
+
+void BackgroundImageLoader::load(const BackgroundImageRequest& request,
+    const void *owner, callback_t callback)
+{
+    /* Piggyback on an identical request if it hasn't finished yet */
+    if (current && (current->request == request))
+    {
+        current->clients.push_back({owner, std::move(callback)});
+        return;
+    }
+
+    for (auto& job : pending)
+    {
+        if (job->request == request)
+        {
+            job->clients.push_back({owner, std::move(callback)});
+            return;
+        }
+    }
+
+    auto job = std::make_shared<job_t>();
+    job->request = request;
+    job->clients.push_back({owner, std::move(callback)});
+    pending.push_back(job);
+    start_next();
+}
+
+void BackgroundImageLoader::cancel(const void *owner)
+{
+    auto remove_clients = [=] (const std::shared_ptr<job_t>& job)
+    {
+        auto& clients = job->clients;
+        clients.erase(std::remove_if(clients.begin(), clients.end(),
+            [=] (const client_t& client) { return client.owner == owner; }),
+            clients.end());
+        return clients.empty();
+    };
+
+    pending.erase(std::remove_if(pending.begin(), pending.end(), remove_clients),
+        pending.end());
+
+    if (finished)
+    {
+        remove_clients(finished);
+    }
+
+    /* Nobody waits for the current decode anymore. It can't be interrupted,
+     * so the next one only starts once it has left its worker. */
+    if (current && remove_clients(current))
+    {
+        current.reset();
+        cancelled_decode_running = true;
+        /* A slot, so that it is disconnected if the loader is destroyed */
+        current_decode.cancel(sigc::slot<void()>(
+            sigc::mem_fun(this, &BackgroundImageLoader::handle_decode_stopped)));
+    }
+}
+
+bool BackgroundImageLoader::busy(const void *owner) const
+{
+    auto has_owner = [=] (const std::shared_ptr<job_t>& job)
+    {
+        return job && std::any_of(job->clients.begin(), job->clients.end(),
+            [=] (const client_t& client) { return client.owner == owner; });
+    };
+
+    return has_owner(current) || has_owner(finished) ||
+           std::any_of(pending.begin(), pending.end(), has_owner);
+}
+
+void BackgroundImageLoader::handle_decode_stopped()
+{
+    cancelled_decode_running = false;
+    start_next();
+}
+
+void BackgroundImageLoader::start_next()
+{
+    if (current || cancelled_decode_running || pending.empty())
+    {
+        return;
+    }
+
+    current = pending.front();
+    pending.pop_front();
+
+    auto request = current->request;
+    current_decode = pool->run<frames_t>([request] () { return decode(request); });
+    current_decode.then(sigc::mem_fun(this, &BackgroundImageLoader::deliver));
+}
+
+void BackgroundImageLoader::deliver(frames_t result)
+{
+    finished = std::move(current);
+    start_next();
+
+    /* Callbacks may queue new requests or cancel existing ones, so we
+     * cannot iterate over the clients while calling. */
+    auto job = finished;
+    while (!job->clients.empty())
+    {
+        auto client = std::move(job->clients.front());
+        job->clients.erase(job->clients.begin());
+        client.callback(job->request, result);
+    }
+
+    if (finished == job)
+    {
+        finished.reset();
+    }
+}
@@ -0,0 +1,137 @@
+#ifndef WF_BACKGROUND_IMAGE_LOADER_HPP
+#define WF_BACKGROUND_IMAGE_LOADER_HPP
+
+#include <cairomm/surface.h>
+#include <gdkmm/pixbuf.h>
+#include <gdkmm/pixbufanimation.h>
+#include <sigc++/trackable.h>
+#include <wf-worker-pool.hpp>
+
+#include <functional>
+#include <memory>
+#include <deque>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/**
+ * Describes a wallpaper decode: the file and the size (in physical pixels)
+ * which it should be scaled to, as well as the scale of the output it is
+ * shown on and the effects applied to the result.
+ */
+struct BackgroundImageRequest
+{
+    std::string path;
+    int width;
+    int height;
+    int scale;
+    bool preserve_aspect;
+    /* In physical pixels */
+    int blur_radius;
+    double dim;
+
+    bool operator ==(const BackgroundImageRequest& other) const
+    {
+        return std::tie(path, width, height, scale, preserve_aspect, blur_radius, dim) ==
+               std::tie(other.path, other.width, other.height, other.scale,
+            other.preserve_aspect, other.blur_radius, other.dim);
+    }
+
+    bool operator <(const BackgroundImageRequest& other) const
+    {
+        return std::tie(path, width, height, scale, preserve_aspect, blur_radius, dim) <
+               std::tie(other.path, other.width, other.height, other.scale,
+            other.preserve_aspect, other.blur_radius, other.dim);
+    }
+};
+
+/* One frame of a decoded wallpaper */
+struct BackgroundImageFrame
+{
+    Cairo::RefPtr<Cairo::ImageSurface> surface;
+    /* Time in milliseconds until the next frame is shown, or -1 if this
+     * frame stays, as for still images */
+    int delay;
+    /* Size of the surface relative to the requested size, below 1 for
+     * animations which are rendered at a lower resolution */
+    double scale_x = 1.0, scale_y = 1.0;
+};
+
+/**
+ * Decodes wallpapers on the worker pool, so that large images do not block
+ * the GTK main loop. Images are decoded one at a time, to bound the peak
+ * memory, and delivered on the main loop in the order the requests were
+ * made. All methods except the static ones must be called from the main
+ * loop.
+ *
+ * Identical requests which are queued at the same time are decoded only
+ * once, and the result is delivered to each of them.
+ */
+class BackgroundImageLoader : public sigc::trackable
+{
+  public:
+    using surface_t = Cairo::RefPtr<Cairo::ImageSurface>;
+    /* Still images have a single frame, animations one frame per step of
+     * their loop */
+    using frames_t = std::vector<BackgroundImageFrame>;
+    /* Called on the main loop. There are no frames if the image failed to load */
+    using callback_t = std::function<void (const BackgroundImageRequest&,
+        const frames_t&)>;
+
+    /* Queue the given request on behalf of owner */
+    void load(const BackgroundImageRequest& request, const void *owner,
+        callback_t callback);
+
+    /* Make sure none of the callbacks queued by owner will be called */
+    void cancel(const void *owner);
+
+    /* Whether owner has requests which have not been delivered yet */
+    bool busy(const void *owner) const;
+
+    /* Decode the image synchronously into premultiplied ARGB32 surfaces,
+     * going through the disk cache for still images. Returns no frames if
+     * unsuccessful. */
+    static frames_t decode(const BackgroundImageRequest& request);
+
+    /* Decode the image file. Still images are decoded at the requested
+     * size, at reduced resolution where the format supports it, so peak
+     * memory is bounded by the output size rather than the source size.
+     * Animations keep their own size. */
+    static Glib::RefPtr<Gdk::PixbufAnimation> decode_at_size(
+        const BackgroundImageRequest& request);
+
+    /* Render one loop of the animation at the requested size. If all frames
+     * would not fit into the frame memory limit, they are rendered at a
+     * lower resolution, which their scale_x and scale_y record. */
+    static frames_t decode_animation(const BackgroundImageRequest& request,
+        const Glib::RefPtr<Gdk::PixbufAnimation>& animation);
+
+  private:
+    struct client_t
+    {
+        const void *owner;
+        callback_t callback;
+    };
+
+    struct job_t
+    {
+        BackgroundImageRequest request;
+        std::vector<client_t> clients;
+    };
+
+    std::shared_ptr<WfWorkerPool> pool = WfWorkerPool::Launch();
+    std::deque<std::shared_ptr<job_t>> pending;
+    /* The job which is being decoded, and the one whose result is being
+     * delivered to its clients */
+    std::shared_ptr<job_t> current, finished;
+    WfFuture<frames_t> current_decode;
+    /* A cancelled decode which is still running on its worker. The next
+     * one only starts once it has stopped. */
+    bool cancelled_decode_running = false;
+
+    void start_next();
+    void handle_decode_stopped();
+    void deliver(frames_t result);
+};
+
+#endif /* end of include guard: WF_BACKGROUND_IMAGE_LOADER_HPP */
@@ -0,0 +1,9 @@
+#include "background.hpp"
+
+int main(int argc, char **argv)
+{
+    WayfireShellApp::create(argc, argv);
+    WayfireBackgroundApp::create();
+    WayfireShellApp::get().run();
+    return 0;
+}
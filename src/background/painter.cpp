@@ -0,0 +1,124 @@
+#include <cmath>
+
+#include "painter.hpp"
+
+bool BackgroundImage::covers(int width, int height) const
+{
+    return source && (x <= 0) && (y <= 0) &&
+           (x + this->width >= width) && (y + this->height >= height);
+}
+
+Cairo::RefPtr<Cairo::Surface> BackgroundPainter::create_native_surface(
+    const Cairo::RefPtr<Cairo::Surface>& source, const create_similar_t& create_similar)
+{
+    auto image = Cairo::RefPtr<Cairo::ImageSurface>::cast_dynamic(source);
+    if (!image)
+    {
+        return source;
+    }
+
+    /* Ask the target which surface it would create for this content. The
+     * shared surface can be used directly if that is an image surface of
+     * the same format, which is the common case. Otherwise, convert it once
+     * here instead of on every frame of the fade. */
+    auto content = image->get_content();
+    auto probe   = Cairo::RefPtr<Cairo::ImageSurface>::cast_dynamic(
+        create_similar(content, 1, 1));
+    if (probe && (probe->get_format() == image->get_format()))
+    {
+        return source;
+    }
+
+    /* The target applies its own scale, so the size is in logical pixels */
+    double scale_x, scale_y;
+    cairo_surface_get_device_scale(image->cobj(), &scale_x, &scale_y);
+    auto native = create_similar(content,
+        std::ceil(image->get_width() / scale_x), std::ceil(image->get_height() / scale_y));
+    auto cr = Cairo::Context::create(native);
+    cr->set_operator(Cairo::OPERATOR_SOURCE);
+    cr->set_source(source, 0, 0);
+    cr->paint();
+    return native;
+}
+
+void BackgroundPainter::set_fill(const BackgroundFill& fill)
+{
+    this->fill = fill;
+    fill_pattern.clear();
+}
+
+void BackgroundPainter::paint_fill(const Cairo::RefPtr<Cairo::Context>& cr,
+    int width, int height)
+{
+    if (fill.type == BackgroundFill::SOLID)
+    {
+        cr->set_source_rgba(fill.color.r, fill.color.g, fill.color.b, fill.color.a);
+        cr->paint();
+        return;
+    }
+
+    if (!fill_pattern || (fill_width != width) || (fill_height != height))
+    {
+        double cx = width / 2.0, cy = height / 2.0;
+        Cairo::RefPtr<Cairo::Gradient> gradient;
+        if (fill.type == BackgroundFill::LINEAR)
+        {
+            /* Span the gradient exactly from one corner to the opposite one
+             * along the given angle */
+            double angle  = fill.angle * M_PI / 180.0;
+            double dx     = std::cos(angle), dy = std::sin(angle);
+            double length = std::abs(cx * dx) + std::abs(cy * dy);
+            gradient = Cairo::LinearGradient::create(cx - dx * length, cy - dy * length,
+                cx + dx * length, cy + dy * length);
+        } else
+        {
+            gradient = Cairo::RadialGradient::create(cx, cy, 0, cx, cy,
+                std::hypot(cx, cy));
+        }
+
+        gradient->add_color_stop_rgba(0, fill.color.r, fill.color.g,
+            fill.color.b, fill.color.a);
+        gradient->add_color_stop_rgba(1, fill.gradient_color.r, fill.gradient_color.g,
+            fill.gradient_color.b, fill.gradient_color.a);
+
+        fill_pattern = gradient;
+        fill_width   = width;
+        fill_height  = height;
+    }
+
+    cr->set_source(fill_pattern);
+    cr->paint();
+}
+
+void BackgroundPainter::paint(const Cairo::RefPtr<Cairo::Context>& cr,
+    int width, int height, const BackgroundImage& to_image,
+    const BackgroundImage& from_image, double alpha)
+{
+    bool fading = from_image.source && (alpha < 1.0);
+
+    /* The fill is only needed where no image covers the area */
+    if (!to_image.covers(width, height) ||
+        (fading && !from_image.covers(width, height)))
+    {
+        paint_fill(cr, width, height);
+    }
+
+    if (!to_image.source)
+    {
+        return;
+    }
+
+    /* Paint the outgoing image as is and blend the new one over it, so that
+     * only one blended paint is needed per frame */
+    if (fading)
+    {
+        cr->set_source(from_image.source, from_image.x, from_image.y);
+        cr->paint();
+        cr->set_source(to_image.source, to_image.x, to_image.y);
+        cr->paint_with_alpha(alpha);
+        return;
+    }
+
+    cr->set_source(to_image.source, to_image.x, to_image.y);
+    cr->paint();
+}
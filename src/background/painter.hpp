@@ -0,0 +1,83 @@
+#ifndef WF_BACKGROUND_PAINTER_HPP
+#define WF_BACKGROUND_PAINTER_HPP
+
+#include <cairomm/context.h>
+#include <cairomm/surface.h>
+#include <wayfire/config/types.hpp>
+
+#include <functional>
+
+#include "image-cache.hpp"
+
+class BackgroundImage
+{
+  public:
+    double x, y;
+    /* Logical size of the image */
+    double width, height;
+    Cairo::RefPtr<Cairo::Surface> source;
+    /* Keeps the shared image alive in the cache while it is shown */
+    BackgroundImageCache::image_t image;
+    /* The frame which is shown, for animations */
+    size_t frame = 0;
+
+    /* Whether the image covers the whole area of the given size */
+    bool covers(int width, int height) const;
+};
+
+/**
+ * A background which is drawn directly, without any image: either a solid
+ * color or a gradient between two colors. It is shown when no image is set
+ * or the image failed to load, and around images which do not cover the
+ * whole output.
+ */
+struct BackgroundFill
+{
+    enum type_t
+    {
+        SOLID,
+        LINEAR,
+        RADIAL,
+    };
+
+    type_t type = SOLID;
+    wf::color_t color;
+    wf::color_t gradient_color;
+    /* Direction of linear gradients in degrees, clockwise from left to right */
+    double angle = 0;
+};
+
+/**
+ * Paints the frames of a background: the fill and the images of a fade.
+ * It only needs a Cairo context, so the benchmark runs the same code as
+ * the outputs do.
+ */
+class BackgroundPainter
+{
+    BackgroundFill fill;
+    /* Gradients are only rebuilt when the fill or the size changes */
+    Cairo::RefPtr<Cairo::Pattern> fill_pattern;
+    int fill_width = 0, fill_height = 0;
+    void paint_fill(const Cairo::RefPtr<Cairo::Context>& cr, int width, int height);
+
+  public:
+    /* Creates a surface of the given content and logical size, of the type
+     * and format which the target prefers */
+    using create_similar_t = std::function<Cairo::RefPtr<Cairo::Surface>(
+        Cairo::Content, int, int)>;
+
+    /* Convert the source to the surface which create_similar prefers, or
+     * return it as is if it already has that format */
+    static Cairo::RefPtr<Cairo::Surface> create_native_surface(
+        const Cairo::RefPtr<Cairo::Surface>& source,
+        const create_similar_t& create_similar);
+
+    void set_fill(const BackgroundFill& fill);
+
+    /* Paint an area of the given size. from_image is only painted while
+     * to_image fades in, i.e. when alpha is below 1. */
+    void paint(const Cairo::RefPtr<Cairo::Context>& cr, int width, int height,
+        const BackgroundImage& to_image, const BackgroundImage& from_image, double alpha);
+};
+
+#endif /* end of include guard: WF_BACKGROUND_PAINTER_HPP */
@@ -1,6 +1,9 @@
 #include "dock.hpp"
 #include "toplevel.hpp"
 #include "toplevel-icon.hpp"
+#include "icon-provider.hpp"
+#include "wf-stats.hpp"
+#include "wf-event-log.hpp"
 #include <iostream>
 #include <gdk/gdkwayland.h>
 
@@ -10,29 +13,6 @@ namespace
 extern zwlr_foreign_toplevel_manager_v1_listener toplevel_manager_v1_impl;
 }
 
-static void registry_add_object(void *data, wl_registry *registry, uint32_t name,
-    const char *interface, uint32_t version)
-{
-    if (strcmp(interface, zwlr_foreign_toplevel_manager_v1_interface.name) == 0)
-    {
-        auto zwlr_toplevel_manager = (zwlr_foreign_toplevel_manager_v1*)
-            wl_registry_bind(registry, name,
-            &zwlr_foreign_toplevel_manager_v1_interface,
-            std::min(version, 1u));
-
-        WfDockApp::get().handle_toplevel_manager(zwlr_toplevel_manager);
-    }
-}
-
-static void registry_remove_object(void *data, struct wl_registry *registry, uint32_t name)
-{}
-
-static struct wl_registry_listener registry_listener =
-{
-    &registry_add_object,
-    &registry_remove_object
-};
-
 class WfDockApp::impl
 {
   public:
@@ -41,21 +21,17 @@ class WfDockApp::impl
     std::map<WayfireOutput*, std::unique_ptr<WfDock>> docks;
 
     zwlr_foreign_toplevel_manager_v1 *toplevel_manager = NULL;
+    WfStatsObject stats{"Dock"};
 };
 
 void WfDockApp::on_activate()
 {
-    WayfireShellApp::on_activate();
     IconProvider::load_custom_icons();
 
-    /* At this point, wayland connection has been initialized,
-     * and hopefully outputs have been created */
-    auto gdk_display = gdk_display_get_default();
-    auto display     = gdk_wayland_display_get_wl_display(gdk_display);
-
-    wl_registry *registry = wl_display_get_registry(display);
-    wl_registry_add_listener(registry, &registry_listener, NULL);
-    wl_display_roundtrip(display);
+    /* At this point, wayland connection has been initialized.
+     * Outputs are added afterwards. */
+    handle_toplevel_manager(WfEventLog::bind_toplevel_manager(
+        *WayfireShellApp::get().registry, 1));
 
     if (!priv->toplevel_manager)
     {
@@ -64,8 +40,7 @@ void WfDockApp::on_activate()
         std::exit(-1);
     }
 
-    wl_registry_destroy(registry);
-    zwlr_foreign_toplevel_manager_v1_add_listener(priv->toplevel_manager,
+    WfEventLog::add_manager_listener(priv->toplevel_manager,
         &toplevel_manager_v1_impl, NULL);
 }
 
@@ -116,6 +91,7 @@ void WfDockApp::handle_toplevel_closed(zwlr_foreign_toplevel_handle_v1 *handle)
     priv->toplevels.erase(handle);
 }
 
+WfDockApp *WfDockApp::instance = nullptr;
 WfDockApp& WfDockApp::get()
 {
     if (!instance)
@@ -123,29 +99,25 @@ WfDockApp& WfDockApp::get()
         throw std::logic_error("Calling WfDockApp::get() before starting app!");
     }
 
-    return dynamic_cast<WfDockApp&>(*instance.get());
+    return *instance;
 }
 
-void WfDockApp::create(int argc, char **argv)
+void WfDockApp::create()
 {
     if (instance)
     {
         throw std::logic_error("Running WfDockApp twice!");
     }
 
-    instance = std::unique_ptr<WfDockApp>{new WfDockApp(argc, argv)};
-    instance->run();
+    instance = new WfDockApp();
+    WayfireShellApp::get().add_component(std::unique_ptr<WayfireShellComponent>(instance));
 }
 
-WfDockApp::WfDockApp(int argc, char **argv) :
-    WayfireShellApp(argc, argv), priv(new WfDockApp::impl())
+WfDockApp::WfDockApp() : priv(new WfDockApp::impl())
 {}
-WfDockApp::~WfDockApp() = default;
-
-int main(int argc, char **argv)
+WfDockApp::~WfDockApp()
 {
-    WfDockApp::create(argc, argv);
-    return 0;
+    instance = nullptr;
 }
 
 using manager_v1_t = zwlr_foreign_toplevel_manager_v1;
@@ -21,8 +21,8 @@ class WfDock::impl
 
     Gtk::HBox box;
 
-    WfOption<std::string> css_path{"dock/css_path"};
-    WfOption<int> dock_height{"dock/dock_height"};
+    WfOption<std::string> css_path{WfOptions::dock::css_path};
+    WfOption<int> dock_height{WfOptions::dock::dock_height};
 
   public:
     impl(WayfireOutput *output)
@@ -24,7 +24,7 @@ class WfDock
     std::unique_ptr<impl> pimpl;
 };
 
-class WfDockApp : public WayfireShellApp
+class WfDockApp : public WayfireShellComponent
 {
   public:
     WfDock *dock_for_wl_output(wl_output *output);
@@ -34,9 +34,9 @@ class WfDockApp : public WayfireShellApp
 
     static WfDockApp& get();
 
-    /* Starts the program. get() is valid afterward the first (and the only)
-     * call to run() */
-    static void create(int argc, char **argv);
+    /* Adds the dock to the shell app. get() is valid afterward the first
+     * (and the only) call to create() */
+    static void create();
     virtual ~WfDockApp();
 
     void on_activate() override;
@@ -44,7 +44,8 @@ class WfDockApp : public WayfireShellApp
     void handle_output_removed(WayfireOutput *output) override;
 
   private:
-    WfDockApp(int argc, char **argv);
+    WfDockApp();
+    static WfDockApp *instance;
 
     class impl;
     std::unique_ptr<impl> priv;
@@ -0,0 +1,9 @@
+#include "dock.hpp"
+
+int main(int argc, char **argv)
+{
+    WayfireShellApp::create(argc, argv);
+    WfDockApp::create();
+    WayfireShellApp::get().run();
+    return 0;
+}
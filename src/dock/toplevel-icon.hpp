@@ -19,11 +19,4 @@ class WfToplevelIcon
     std::unique_ptr<impl> pimpl;
 };
 
-namespace IconProvider
-{
-/* Loads custom app_id -> icon file mappings from the section
-* They have the format icon_mapping_<app_id> = <icon file> */
-void load_custom_icons();
-}
-
 #endif /* end of include guard: WF_DOCK_TOPLEVEL_ICON_HPP */
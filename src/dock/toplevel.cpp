@@ -1,6 +1,7 @@
 #include "toplevel.hpp"
 #include "toplevel-icon.hpp"
 #include "dock.hpp"
+#include "wf-event-log.hpp"
 #include <cassert>
 
 namespace
@@ -19,8 +20,7 @@ class WfToplevel::impl
     impl(zwlr_foreign_toplevel_handle_v1 *handle)
     {
         this->handle = handle;
-        zwlr_foreign_toplevel_handle_v1_add_listener(handle,
-            &toplevel_handle_v1_impl, this);
+        WfEventLog::add_toplevel_listener(handle, &toplevel_handle_v1_impl, this);
     }
 
     void handle_output_enter(wl_output *output)
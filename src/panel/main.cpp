@@ -0,0 +1,9 @@
+#include "panel.hpp"
+
+int main(int argc, char **argv)
+{
+    WayfireShellApp::create(argc, argv);
+    WayfirePanelApp::create();
+    WayfireShellApp::get().run();
+    return 0;
+}
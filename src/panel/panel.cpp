@@ -6,6 +6,7 @@
 #include <gtkmm/hvbox.h>
 #include <gtkmm/window.h>
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <sstream>
@@ -14,6 +15,8 @@
 #include <map>
 
 #include "../util/gtk-utils.hpp"
+#include "wf-trace.hpp"
+#include "wf-stats.hpp"
 #include "panel.hpp"
 
 #include "widgets/battery.hpp"
@@ -46,7 +49,7 @@ class WayfirePanel::impl
 
     WayfireOutput *output;
 
-    WfOption<std::string> bg_color{"panel/background_color"};
+    WfOption<std::string> bg_color{WfOptions::panel::background_color};
     std::function<void()> on_window_color_updated = [=] ()
     {
         if (bg_color.value() == "gtk_default")
@@ -77,7 +80,7 @@ class WayfirePanel::impl
         window->override_background_color(rgba);
     };
 
-    WfOption<std::string> panel_layer{"panel/layer"};
+    WfOption<std::string> panel_layer{WfOptions::panel::layer};
     std::function<void()> set_panel_layer = [=] ()
     {
         if (panel_layer.value() == "overlay")
@@ -101,11 +104,12 @@ class WayfirePanel::impl
         }
     };
 
-    WfOption<int> minimal_panel_height{"panel/minimal_height"};
-    WfOption<std::string> css_path{"panel/css_path"};
+    WfOption<int> minimal_panel_height{WfOptions::panel::minimal_height};
+    WfOption<std::string> css_path{WfOptions::panel::css_path};
 
     void create_window()
     {
+        WfTraceSpan span{"WayfirePanel::impl::create_window"};
         window = std::make_unique<WayfireAutohidingWindow>(output, "panel");
         window->set_size_request(1, minimal_panel_height);
         panel_layer.set_callback(set_panel_layer);
@@ -133,8 +137,19 @@ class WayfirePanel::impl
         init_layout();
 
         window->signal_delete_event().connect(sigc::mem_fun(this, &WayfirePanel::impl::on_delete));
+        if (WfTrace::enabled())
+        {
+            first_frame_conn = window->signal_draw().connect([=] (auto&)
+            {
+                WfTrace::instant("first frame", output->monitor->get_model());
+                first_frame_conn.disconnect();
+                return false;
+            }, false);
+        }
     }
 
+    sigc::connection first_frame_conn;
+
     bool on_delete(GdkEventAny *ev)
     {
         /* We ignore close events, because the panel's lifetime is bound to
@@ -273,14 +288,32 @@ class WayfirePanel::impl
             }
 
             widget->widget_name = widget_name;
-            widget->init(&box);
+            widget->stats = WayfirePanelApp::get().get_widget_counters(widget_name);
+
+            auto old_children = box.get_children();
+            {
+                WfTraceSpan span{"WayfireWidget::init", widget_name};
+                WfStatsScope scope{widget->stats};
+                widget->init(&box);
+            }
+
+            /* Measure the GTK widgets which the widget added to the panel */
+            for (auto child : box.get_children())
+            {
+                if (std::find(old_children.begin(), old_children.end(), child) ==
+                    old_children.end())
+                {
+                    WfStats::watch_widget(*child, widget->stats);
+                }
+            }
+
             container.push_back(std::move(widget));
         }
     }
 
-    WfOption<std::string> left_widgets_opt{"panel/widgets_left"};
-    WfOption<std::string> right_widgets_opt{"panel/widgets_right"};
-    WfOption<std::string> center_widgets_opt{"panel/widgets_center"};
+    WfOption<std::string> left_widgets_opt{WfOptions::panel::widgets_left};
+    WfOption<std::string> right_widgets_opt{WfOptions::panel::widgets_right};
+    WfOption<std::string> center_widgets_opt{WfOptions::panel::widgets_center};
     void init_widgets()
     {
         left_widgets_opt.set_callback([=] ()
@@ -324,21 +357,18 @@ class WayfirePanel::impl
         return *window;
     }
 
-    void handle_config_reload()
+    void handle_config_reload(const std::set<std::string>& changed)
     {
-        for (auto & w : left_widgets)
+        for (auto widgets : {&left_widgets, &right_widgets, &center_widgets})
         {
-            w->handle_config_reload();
-        }
-
-        for (auto & w : right_widgets)
-        {
-            w->handle_config_reload();
-        }
-
-        for (auto & w : center_widgets)
-        {
-            w->handle_config_reload();
+            for (auto & w : *widgets)
+            {
+                if (w->needs_config_reload(changed))
+                {
+                    WfStatsScope scope{w->stats};
+                    w->handle_config_reload();
+                }
+            }
         }
     }
 };
@@ -356,22 +386,28 @@ Gtk::Window& WayfirePanel::get_window()
     return pimpl->get_window();
 }
 
-void WayfirePanel::handle_config_reload()
+void WayfirePanel::handle_config_reload(const std::set<std::string>& changed)
 {
-    return pimpl->handle_config_reload();
+    return pimpl->handle_config_reload(changed);
 }
 
 class WayfirePanelApp::impl
 {
   public:
     std::map<WayfireOutput*, std::unique_ptr<WayfirePanel>> panels;
+    WfStatsObject stats{"Panel"};
 };
 
-void WayfirePanelApp::on_config_reload()
+WfStatsCounters*WayfirePanelApp::get_widget_counters(const std::string& widget_name)
+{
+    return priv->stats.get_counters(widget_name);
+}
+
+void WayfirePanelApp::on_config_reload(const std::set<std::string>& changed)
 {
     for (auto & p : priv->panels)
     {
-        p.second->handle_config_reload();
+        p.second->handle_config_reload(changed);
     }
 }
 
@@ -398,6 +434,7 @@ void WayfirePanelApp::handle_output_removed(WayfireOutput *output)
     priv->panels.erase(output);
 }
 
+WayfirePanelApp *WayfirePanelApp::instance = nullptr;
 WayfirePanelApp& WayfirePanelApp::get()
 {
     if (!instance)
@@ -405,25 +442,24 @@ WayfirePanelApp& WayfirePanelApp::get()
         throw std::logic_error("Calling WayfirePanelApp::get() before starting app!");
     }
 
-    return dynamic_cast<WayfirePanelApp &>(*instance);
+    return *instance;
 }
 
-void WayfirePanelApp::create(int argc, char **argv)
+void WayfirePanelApp::create()
 {
     if (instance)
     {
         throw std::logic_error("Running WayfirePanelApp twice!");
     }
 
-    instance = std::unique_ptr<WayfireShellApp>(new WayfirePanelApp{argc, argv});
-    instance->run();
+    instance = new WayfirePanelApp();
+    WayfireShellApp::get().add_component(std::unique_ptr<WayfireShellComponent>(instance));
 }
 
-WayfirePanelApp::WayfirePanelApp(int argc, char **argv) : WayfireShellApp(argc, argv), priv(new impl())
+WayfirePanelApp::WayfirePanelApp() : priv(new impl())
 {}
 
-int main(int argc, char **argv)
+WayfirePanelApp::~WayfirePanelApp()
 {
-    WayfirePanelApp::create(argc, argv);
-    return 0;
+    instance = nullptr;
 }
@@ -7,6 +7,8 @@
 
 #include "wf-shell-app.hpp"
 
+struct WfStatsCounters;
+
 class WayfirePanel
 {
   public:
@@ -14,30 +16,39 @@ class WayfirePanel
 
     wl_surface *get_wl_surface();
     Gtk::Window & get_window();
-    void handle_config_reload();
+    void handle_config_reload(const std::set<std::string>& changed);
 
   private:
     class impl;
     std::unique_ptr<impl> pimpl;
 };
 
-class WayfirePanelApp : public WayfireShellApp
+class WayfirePanelApp : public WayfireShellComponent
 {
   public:
     WayfirePanel *panel_for_wl_output(wl_output *output);
+    /* Counters of the widgets with the given name on all outputs */
+    WfStatsCounters *get_widget_counters(const std::string& widget_name);
     static WayfirePanelApp & get();
 
-    /* Starts the program. get() is valid afterward the first (and the only)
-     * call to create() */
-    static void create(int argc, char **argv);
-    ~WayfirePanelApp() override = default;
+    /* Adds the panel to the shell app. get() is valid afterward the first
+     * (and the only) call to create() */
+    static void create();
+    ~WayfirePanelApp() override;
 
     void handle_new_output(WayfireOutput *output) override;
     void handle_output_removed(WayfireOutput *output) override;
-    void on_config_reload() override;
+    /* Panels are kept while their output is detached. The window moves
+     * itself to the new monitor, and the widgets keep their state. */
+    void handle_output_detached(WayfireOutput *output) override
+    {}
+    void handle_output_reattached(WayfireOutput *output) override
+    {}
+    void on_config_reload(const std::set<std::string>& changed) override;
 
   private:
-    WayfirePanelApp(int argc, char **argv);
+    WayfirePanelApp();
+    static WayfirePanelApp *instance;
 
     class impl;
     std::unique_ptr<impl> priv;
@@ -2,7 +2,10 @@
 #define WIDGET_HPP
 
 #include <gtkmm/hvbox.h>
+#include <set>
+#include <string>
 #include <wf-option-wrap.hpp>
+#include <wf-stats.hpp>
 #include <wayfire/config/types.hpp>
 
 #define DEFAULT_PANEL_HEIGHT "48"
@@ -12,14 +15,34 @@
 #define PANEL_POSITION_TOP "top"
 
 class wayfire_config;
+
+/* Whether the name of any of the changed options starts with prefix */
+inline bool config_changed_with_prefix(const std::set<std::string>& changed,
+    const std::string& prefix)
+{
+    auto it = changed.lower_bound(prefix);
+    return it != changed.end() && it->compare(0, prefix.size(), prefix) == 0;
+}
+
 class WayfireWidget
 {
   public:
     std::string widget_name; // for WayfirePanel use, widgets shouldn't change it
+    /* Set by WayfirePanel before init(), callbacks which may be expensive
+     * should be measured with a WfStatsScope */
+    WfStatsCounters *stats = nullptr;
 
     virtual void init(Gtk::HBox *container) = 0;
     virtual void handle_config_reload()
     {}
+
+    /* Whether handle_config_reload() needs to be called after the given
+     * options changed. By default, the widget is reloaded on every change. */
+    virtual bool needs_config_reload(const std::set<std::string>& changed)
+    {
+        return true;
+    }
+
     virtual ~WayfireWidget()
     {}
 };
@@ -1,5 +1,6 @@
 #include "battery.hpp"
 #include <gtk-utils.hpp>
+#include <wf-trace.hpp>
 #include <iostream>
 #include <algorithm>
 
@@ -33,6 +34,7 @@ void WayfireBatteryInfo::on_properties_changed(
     const Gio::DBus::Proxy::MapChangedProperties& properties,
     const std::vector<Glib::ustring>& invalidated)
 {
+    WfStatsScope scope{stats};
     bool invalid_icon = false, invalid_details = false;
     bool invalid_state = false;
     for (auto& prop : properties)
@@ -182,6 +184,7 @@ void WayfireBatteryInfo::update_state()
 
 bool WayfireBatteryInfo::setup_dbus()
 {
+    WfTraceSpan span{"WayfireBatteryInfo::setup_dbus"};
     auto cancellable = Gio::Cancellable::create();
     connection = Gio::DBus::Connection::get_sync(Gio::DBus::BUS_TYPE_SYSTEM, cancellable);
     if (!connection)
@@ -193,6 +196,7 @@ bool WayfireBatteryInfo::setup_dbus()
     upower_proxy = Gio::DBus::Proxy::create_sync(connection, UPOWER_NAME,
         "/org/freedesktop/UPower",
         "org.freedesktop.UPower");
+    WfStats::track_proxy(upower_proxy);
     if (!upower_proxy)
     {
         std::cerr << "Failed to connect to UPower" << std::endl;
@@ -203,6 +207,7 @@ bool WayfireBatteryInfo::setup_dbus()
         UPOWER_NAME,
         DISPLAY_DEVICE,
         "org.freedesktop.UPower.Device");
+    WfStats::track_proxy(display_device);
     if (!display_device)
     {
         return false;
@@ -21,10 +21,10 @@ static const std::string BATTERY_STATUS_FULL    = "full"; // icon + percentage +
 class wayfire_config;
 class WayfireBatteryInfo : public WayfireWidget
 {
-    WfOption<std::string> status_opt{"panel/battery_status"};
-    WfOption<std::string> font_opt{"panel/battery_font"};
-    WfOption<int> size_opt{"panel/battery_icon_size"};
-    WfOption<bool> invert_opt{"panel/battery_icon_invert"};
+    WfOption<std::string> status_opt{WfOptions::panel::battery_status};
+    WfOption<std::string> font_opt{WfOptions::panel::battery_font};
+    WfOption<int> size_opt{WfOptions::panel::battery_icon_size};
+    WfOption<bool> invert_opt{WfOptions::panel::battery_icon_invert};
 
     Gtk::Button button;
     Gtk::Label label;
@@ -1,6 +1,7 @@
 #include <glibmm.h>
 #include <iostream>
 #include "clock.hpp"
+#include <wf-stats.hpp>
 
 void WayfireClock::init(Gtk::HBox *container)
 {
@@ -19,7 +20,7 @@ void WayfireClock::init(Gtk::HBox *container)
 
     container->pack_start(*button, false, false);
 
-    timeout = Glib::signal_timeout().connect_seconds(
+    timeout = WfStats::signal_timeout().connect_seconds(
         sigc::mem_fun(this, &WayfireClock::update_label), 1);
 
     // initially set font
@@ -39,6 +40,7 @@ void WayfireClock::on_calendar_shown()
 
 bool WayfireClock::update_label()
 {
+    WfStatsScope scope{stats};
     auto time = Glib::DateTime::create_now_local();
     auto text = time.format((std::string)format);
 
@@ -13,8 +13,8 @@ class WayfireClock : public WayfireWidget
     std::unique_ptr<WayfireMenuButton> button;
 
     sigc::connection timeout;
-    WfOption<std::string> format{"panel/clock_format"};
-    WfOption<std::string> font{"panel/clock_font"};
+    WfOption<std::string> format{WfOptions::panel::clock_format};
+    WfOption<std::string> font{WfOptions::panel::clock_font};
 
     void set_font();
     void on_calendar_shown();
@@ -9,6 +9,7 @@
 #include <array>
 
 #include <gtk-utils.hpp>
+#include <wf-stats.hpp>
 
 static void label_set_from_command(std::string command_line,
     Gtk::Label& label)
@@ -100,7 +101,7 @@ WfCommandOutputButtons::CommandOutput::CommandOutput(const std::string & name,
 
     if (period > 0)
     {
-        timeout_connection = Glib::signal_timeout().connect_seconds([=] ()
+        timeout_connection = WfStats::signal_timeout().connect_seconds([=] ()
         {
             update_output();
             return true;
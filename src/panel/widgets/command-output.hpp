@@ -23,7 +23,7 @@ class WfCommandOutputButtons : public WayfireWidget
         Gtk::Label tooltip_label;
         time_t last_tooltip_update = 0;
 
-        WfOption<int> max_chars_opt{"panel/commands_output_max_chars"};
+        WfOption<int> max_chars_opt{WfOptions::panel::commands_output_max_chars};
 
         void init();
 
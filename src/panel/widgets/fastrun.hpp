@@ -34,6 +34,10 @@ class WayfireFastRun : public WayfireWidget
   public:
     void init(Gtk::HBox *container) override;
     void handle_config_reload() override;
+    bool needs_config_reload(const std::set<std::string>& changed) override
+    {
+        return config_changed_with_prefix(changed, "panel/fastrun_");
+    }
 };
 
 #endif /* end of include guard: WIDGETS_CLOCK_HPP */
@@ -120,7 +120,7 @@ void WfLauncherButton::set_size(int size)
 bool WfLauncherButton::initialize(std::string name, std::string icon, std::string label)
 {
     launcher_name = name;
-    base_size     = WfOption<int>{"panel/launchers_size"} / LAUNCHERS_ICON_SCALE;
+    base_size     = WfOptions::panel::launchers_size.value() / LAUNCHERS_ICON_SCALE;
     if (icon == "none")
     {
         auto dl = new DesktopLauncherInfo();
@@ -189,7 +189,7 @@ bool WfLauncherButton::on_click(GdkEventButton *ev)
 
 static int get_animation_duration(int start, int end, int scale)
 {
-    return WfOption<int>{"panel/launchers_animation_duration"}.value();
+    return WfOptions::panel::launchers_animation_duration.value();
 }
 
 bool WfLauncherButton::on_enter(GdkEventCrossing *ev)
@@ -330,7 +330,7 @@ void WayfireLaunchers::init(Gtk::HBox *container)
 
 void WayfireLaunchers::handle_config_reload()
 {
-    box.set_spacing(WfOption<int>{"panel/launchers_spacing"});
+    box.set_spacing(WfOptions::panel::launchers_spacing.value());
 
     launchers = get_launchers_from_config();
     for (auto& l : launchers)
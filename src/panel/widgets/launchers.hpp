@@ -71,6 +71,12 @@ class WayfireLaunchers : public WayfireWidget
   public:
     virtual void init(Gtk::HBox *container);
     virtual void handle_config_reload();
+    /* Covers both the launcher_* entries and the launchers_* options */
+    bool needs_config_reload(const std::set<std::string>& changed) override
+    {
+        return config_changed_with_prefix(changed, "panel/launcher");
+    }
+
     virtual ~WayfireLaunchers()
     {}
 };
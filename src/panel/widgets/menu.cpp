@@ -143,7 +143,8 @@ static bool ends_with(std::string text, std::string pattern)
     return text.substr(text.length() - pattern.length()) == pattern;
 }
 
-void WayfireMenu::load_menu_items_from_dir(std::string path)
+/* Runs on the worker pool */
+static void find_menu_items_in_dir(std::string path, std::vector<AppInfo>& apps)
 {
     /* Expand path */
     auto dir = opendir(path.c_str());
@@ -166,21 +167,40 @@ void WayfireMenu::load_menu_items_from_dir(std::string path)
 
         if (ends_with(fullpath, ".desktop"))
         {
-            load_menu_item(Gio::DesktopAppInfo::create_from_filename(fullpath));
+            apps.push_back(Gio::DesktopAppInfo::create_from_filename(fullpath));
         }
     }
+
+    closedir(dir);
 }
 
 void WayfireMenu::load_menu_items_all()
 {
+    /* Reading all desktop files takes a while, so it is done on the worker
+     * pool and only the widgets are created on the main loop */
     std::string home_dir = getenv("HOME");
-    auto app_list = Gio::AppInfo::get_all();
-    for (auto app : app_list)
+    menu_items = WfWorkerPool::Launch()->run<std::vector<AppInfo>>([home_dir] ()
     {
-        load_menu_item(app);
-    }
+        std::vector<AppInfo> apps;
+        for (auto app : Gio::AppInfo::get_all())
+        {
+            apps.push_back(app);
+        }
+
+        find_menu_items_in_dir(home_dir + "/Desktop", apps);
+        return apps;
+    });
 
-    load_menu_items_from_dir(home_dir + "/Desktop");
+    menu_items.then([=] (std::vector<AppInfo> apps)
+    {
+        WfStatsScope scope{stats};
+        for (auto& app : apps)
+        {
+            load_menu_item(app);
+        }
+
+        flowbox.show_all();
+    });
 }
 
 void WayfireMenu::on_search_changed()
@@ -418,7 +438,6 @@ void WayfireMenu::refresh()
     }
 
     load_menu_items_all();
-    flowbox.show_all();
 }
 
 static void app_info_changed(GAppInfoMonitor *gappinfomonitor, gpointer user_data)
@@ -3,6 +3,7 @@
 
 #include "../widget.hpp"
 #include "wf-popover.hpp"
+#include "wf-worker-pool.hpp"
 #include <giomm/desktopappinfo.h>
 #include <gtkmm/searchentry.h>
 #include <gtkmm/image.h>
@@ -44,12 +45,12 @@ class WayfireLogoutUI
 {
   public:
     WayfireLogoutUI();
-    WfOption<std::string> logout_command{"panel/logout_command"};
-    WfOption<std::string> reboot_command{"panel/reboot_command"};
-    WfOption<std::string> shutdown_command{"panel/shutdown_command"};
-    WfOption<std::string> suspend_command{"panel/suspend_command"};
-    WfOption<std::string> hibernate_command{"panel/hibernate_command"};
-    WfOption<std::string> switchuser_command{"panel/switchuser_command"};
+    WfOption<std::string> logout_command{WfOptions::panel::logout_command};
+    WfOption<std::string> reboot_command{WfOptions::panel::reboot_command};
+    WfOption<std::string> shutdown_command{WfOptions::panel::shutdown_command};
+    WfOption<std::string> suspend_command{WfOptions::panel::suspend_command};
+    WfOption<std::string> hibernate_command{WfOptions::panel::hibernate_command};
+    WfOption<std::string> switchuser_command{WfOptions::panel::switchuser_command};
     Gtk::Window ui, bg;
     Gtk::HBox bg_box;
     WayfireLogoutUIButton logout;
@@ -87,8 +88,9 @@ class WayfireMenu : public WayfireWidget
     guint app_info_monitor_changed_handler_id;
 
     void load_menu_item(const AppInfo & app_info);
-    void load_menu_items_from_dir(std::string directory);
     void load_menu_items_all();
+    /* Destroyed with the menu, so that no items are added afterwards */
+    WfFuture<std::vector<AppInfo>> menu_items;
 
     bool update_icon();
 
@@ -106,13 +108,13 @@ class WayfireMenu : public WayfireWidget
     std::set<std::pair<std::string, std::string>> loaded_apps;
     gulong app_info_monitor_connection;
 
-    WfOption<std::string> menu_logout_command{"panel/menu_logout_command"};
-    WfOption<bool> fuzzy_search_enabled{"panel/menu_fuzzy_search"};
-    WfOption<std::string> panel_position{"panel/position"};
-    WfOption<std::string> menu_icon{"panel/menu_icon"};
-    WfOption<int> menu_size{"panel/launchers_size"};
-    WfOption<int> menu_min_content_width{"panel/menu_min_content_width"};
-    WfOption<int> menu_min_content_height{"panel/menu_min_content_height"};
+    WfOption<std::string> menu_logout_command{WfOptions::panel::menu_logout_command};
+    WfOption<bool> fuzzy_search_enabled{WfOptions::panel::menu_fuzzy_search};
+    WfOption<std::string> panel_position{WfOptions::panel::position};
+    WfOption<std::string> menu_icon{WfOptions::panel::menu_icon};
+    WfOption<int> menu_size{WfOptions::panel::launchers_size};
+    WfOption<int> menu_min_content_width{WfOptions::panel::menu_min_content_width};
+    WfOption<int> menu_min_content_height{WfOptions::panel::menu_min_content_height};
     void update_popover_layout();
     void create_logout_ui();
     void on_logout_click();
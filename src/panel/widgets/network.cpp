@@ -3,6 +3,7 @@
 #include <cassert>
 #include <iostream>
 #include <gtk-utils.hpp>
+#include <wf-trace.hpp>
 
 #define NM_DBUS_NAME "org.freedesktop.NetworkManager"
 #define ACTIVE_CONNECTION "PrimaryConnection"
@@ -57,6 +58,7 @@ struct WifiConnectionInfo : public WfNetworkConnectionInfo
 
         ap = Gio::DBus::Proxy::create_sync(connection, NM_DBUS_NAME, path,
             "org.freedesktop.NetworkManager.AccessPoint");
+        WfStats::track_proxy(ap);
 
         if (ap)
         {
@@ -290,6 +292,7 @@ void WayfireNetworkInfo::update_active_connection()
         active_connection_proxy = Gio::DBus::Proxy::create_sync(
             connection, NM_DBUS_NAME, active_conn_path.get(),
             "org.freedesktop.NetworkManager.Connection.Active");
+        WfStats::track_proxy(active_connection_proxy);
     } else
     {
         active_connection_proxy = DBusProxy();
@@ -345,6 +348,7 @@ void WayfireNetworkInfo::on_nm_properties_changed(
     const Gio::DBus::Proxy::MapChangedProperties& properties,
     const std::vector<Glib::ustring>& invalidated)
 {
+    WfStatsScope scope{stats};
     for (auto & prop : properties)
     {
         if (prop.first == ACTIVE_CONNECTION)
@@ -356,6 +360,7 @@ void WayfireNetworkInfo::on_nm_properties_changed(
 
 bool WayfireNetworkInfo::setup_dbus()
 {
+    WfTraceSpan span{"WayfireNetworkInfo::setup_dbus"};
     auto cancellable = Gio::Cancellable::create();
     connection = Gio::DBus::Connection::get_sync(Gio::DBus::BUS_TYPE_SYSTEM, cancellable);
     if (!connection)
@@ -367,6 +372,7 @@ bool WayfireNetworkInfo::setup_dbus()
     nm_proxy = Gio::DBus::Proxy::create_sync(connection, NM_DBUS_NAME,
         "/org/freedesktop/NetworkManager",
         "org.freedesktop.NetworkManager");
+    WfStats::track_proxy(nm_proxy);
     if (!nm_proxy)
     {
         std::cerr << "Failed to connect to network manager, " <<
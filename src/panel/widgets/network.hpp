@@ -61,12 +61,12 @@ class WayfireNetworkInfo : public WayfireWidget
     Gtk::Label status;
 
     bool enabled = true;
-    WfOption<std::string> status_opt{"panel/network_status"};
-    WfOption<int> icon_size_opt{"panel/network_icon_size"};
-    WfOption<bool> icon_invert_opt{"panel/network_icon_invert_color"};
-    WfOption<bool> status_color_opt{"panel/network_status_use_color"};
-    WfOption<std::string> status_font_opt{"panel/network_status_font"};
-    WfOption<std::string> click_command_opt{"panel/network_onclick_command"};
+    WfOption<std::string> status_opt{WfOptions::panel::network_status};
+    WfOption<int> icon_size_opt{WfOptions::panel::network_icon_size};
+    WfOption<bool> icon_invert_opt{WfOptions::panel::network_icon_invert_color};
+    WfOption<bool> status_color_opt{WfOptions::panel::network_status_use_color};
+    WfOption<std::string> status_font_opt{WfOptions::panel::network_status_font};
+    WfOption<std::string> click_command_opt{WfOptions::panel::network_onclick_command};
 
     bool setup_dbus();
     void update_active_connection();
@@ -81,6 +81,11 @@ class WayfireNetworkInfo : public WayfireWidget
 
     void init(Gtk::HBox *container);
     void handle_config_reload();
+    bool needs_config_reload(const std::set<std::string>& changed) override
+    {
+        return config_changed_with_prefix(changed, "panel/network_");
+    }
+
     virtual ~WayfireNetworkInfo();
 };
 
@@ -4,6 +4,8 @@
 #include "daemon.hpp"
 #include "notification-info.hpp"
 
+#include <wf-event-log.hpp>
+
 #include <iostream>
 
 #define FDN_PATH "/org/freedesktop/Notifications"
@@ -64,12 +66,22 @@ dbus_method(Daemon::GetCapabilities)
 
 dbus_method(Daemon::Notify)
 try {
+    WfEventLog::record_notify(sender, parameters);
     const auto notification = Notification(parameters, sender);
-    const auto id     = notification.id;
     const auto id_var =
-        Glib::VariantContainerBase::create_tuple(Glib::Variant<Notification::id_type>::create(id));
+        Glib::VariantContainerBase::create_tuple(Glib::Variant<Notification::id_type>::create(
+            notification.id));
 
     invocation->return_value(id_var);
+    addNotification(notification);
+} catch (const std::exception & err)
+{
+    std::cerr << "Error at " << __PRETTY_FUNCTION__ << ": " << err.what() << '\n';
+}
+
+void Daemon::addNotification(const Notification & notification)
+{
+    const auto id = notification.id;
 
     bool is_replacing = notifications.count(id) == 1;
     if (is_replacing)
@@ -86,9 +98,6 @@ try {
     {
         signal_notification_new.emit(id);
     }
-} catch (const std::exception & err)
-{
-    std::cerr << "Error at " << __PRETTY_FUNCTION__ << ": " << err.what() << '\n';
 }
 
 dbus_method(Daemon::CloseNotification)
@@ -153,10 +162,22 @@ Daemon::Daemon() :
     owner_id(Gio::DBus::own_name(Gio::DBus::BUS_TYPE_SESSION, FDN_NAME,
         sigc::mem_fun(this, &Daemon::on_bus_acquired),
         {}, {}, Gio::DBus::BUS_NAME_OWNER_FLAGS_REPLACE))
-{}
+{
+    replay_conn = WfEventLog::replayed_notify_signal().connect(
+        [this] (const Glib::ustring & sender, const Glib::VariantContainerBase & parameters)
+    {
+        try {
+            addNotification(Notification(parameters, sender));
+        } catch (const std::exception & err)
+        {
+            std::cerr << "Error replaying a notification: " << err.what() << '\n';
+        }
+    });
+}
 
 Daemon::~Daemon()
 {
+    replay_conn.disconnect();
     daemon_connection->unregister_object(object_id);
     Gio::DBus::unown_name(owner_id);
 }
@@ -75,8 +75,13 @@ class Daemon
 
     const Gio::DBus::InterfaceVTable interface_vtable{sigc::mem_fun(this, &Daemon::on_interface_method_call)};
 
+    /* Replayed Notify calls, see WfEventLog */
+    sigc::connection replay_conn;
+
     Daemon();
 
+    void addNotification(const Notification & notification);
+
     void on_interface_method_call(const Glib::RefPtr<Gio::DBus::Connection> & connection,
         const Glib::ustring & sender,
         const Glib::ustring & object_path, const Glib::ustring & interface_name,
@@ -3,6 +3,7 @@
 #include <glibmm/main.h>
 
 #include <gtk-utils.hpp>
+#include <wf-stats.hpp>
 
 #include "single-notification.hpp"
 
@@ -64,7 +65,7 @@ void WayfireNotificationCenter::newNotification(Notification::id_type id, bool s
         if ((timeout > 0) && (!popover_timeout.empty() || !popover->is_visible()))
         {
             popover_timeout.disconnect();
-            popover_timeout = Glib::signal_timeout().connect(
+            popover_timeout = WfStats::signal_timeout().connect(
                 [=]
             {
                 popover->popdown();
@@ -3,6 +3,7 @@
 
 #include <glibmm/main.h>
 #include <gtk-utils.hpp>
+#include <wf-stats.hpp>
 #include <gtkmm/icontheme.h>
 
 #include <ctime>
@@ -70,7 +71,7 @@ WfSingleNotification::WfSingleNotification(const Notification & notification)
 
     time_label.set_sensitive(false);
     time_label.set_label(format_recv_time(notification.additional_info.recv_time));
-    time_label_update = Glib::signal_timeout().connect(
+    time_label_update = WfStats::signal_timeout().connect(
         [=]
     {
         time_label.set_label(format_recv_time(notification.additional_info.recv_time));
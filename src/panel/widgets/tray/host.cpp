@@ -2,6 +2,9 @@
 #include "tray.hpp"
 #include "watcher.hpp"
 
+#include <wf-event-log.hpp>
+#include <wf-stats.hpp>
+
 StatusNotifierHost::StatusNotifierHost(WayfireStatusNotifier *tray) :
     dbus_name_id(Gio::DBus::own_name(Gio::DBus::BUS_TYPE_SESSION,
         "org.kde.StatusNotifierHost-" + std::to_string(getpid()) + "-" +
@@ -24,12 +27,14 @@ void StatusNotifierHost::on_bus_acquired(const Glib::RefPtr<Gio::DBus::Connectio
             [this, host_name] (const Glib::RefPtr<Gio::AsyncResult> & result)
         {
             watcher_proxy = Gio::DBus::Proxy::create_finish(result);
+            WfStats::track_proxy(watcher_proxy);
             watcher_proxy->call("RegisterStatusNotifierHost",
                 Glib::Variant<std::tuple<Glib::ustring>>::create({host_name}));
             watcher_proxy->signal_signal().connect([this] (const Glib::ustring & sender_name,
                                                            const Glib::ustring & signal_name,
                                                            const Glib::VariantContainerBase & params)
             {
+                WfEventLog::record_sni_signal("", signal_name, params);
                 if (!params.is_of_type(Glib::VariantType("(s)")))
                 {
                     return;
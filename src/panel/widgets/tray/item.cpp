@@ -2,6 +2,8 @@
 
 #include <gtk-utils.hpp>
 #include <wf-autohide-window.hpp>
+#include <wf-event-log.hpp>
+#include <wf-stats.hpp>
 
 #include <gtkmm/icontheme.h>
 #include <gtkmm/tooltip.h>
@@ -54,12 +56,17 @@ StatusNotifierItem::StatusNotifierItem(const Glib::ustring & service)
     dbus_name = name;
     Gio::DBus::Proxy::create_for_bus(
         Gio::DBus::BUS_TYPE_SESSION, name, path, "org.kde.StatusNotifierItem",
-        [this] (const Glib::RefPtr<Gio::AsyncResult> & result)
+        [this, service] (const Glib::RefPtr<Gio::AsyncResult> & result)
     {
         item_proxy = Gio::DBus::Proxy::create_for_bus_finish(result);
+        WfStats::track_proxy(item_proxy);
         item_proxy->signal_signal().connect(
-            [this] (const Glib::ustring & sender, const Glib::ustring & signal,
-                    const Glib::VariantContainerBase & params) { handle_signal(signal, params); });
+            [this, service] (const Glib::ustring & sender, const Glib::ustring & signal,
+                             const Glib::VariantContainerBase & params)
+        {
+            WfEventLog::record_sni_signal(service, signal, params);
+            handle_signal(signal, params);
+        });
         init_widget();
     });
 }
@@ -277,6 +284,16 @@ void StatusNotifierItem::handle_signal(const Glib::ustring & signal,
     }
 }
 
+void StatusNotifierItem::handle_replayed_signal(const Glib::ustring & signal,
+    const Glib::VariantContainerBase & params)
+{
+    /* The proxy is created asynchronously */
+    if (item_proxy)
+    {
+        handle_signal(signal, params);
+    }
+}
+
 void StatusNotifierItem::fetch_property(const Glib::ustring & property_name,
     const sigc::slot<void> & callback)
 {
@@ -14,9 +14,9 @@
 
 class StatusNotifierItem : public Gtk::EventBox
 {
-    WfOption<int> smooth_scolling_threshold{"panel/tray_smooth_scrolling_threshold"};
-    WfOption<int> icon_size{"panel/tray_icon_size"};
-    WfOption<bool> menu_on_middle_click{"panel/tray_menu_on_middle_click"};
+    WfOption<int> smooth_scolling_threshold{WfOptions::panel::tray_smooth_scrolling_threshold};
+    WfOption<int> icon_size{WfOptions::panel::tray_icon_size};
+    WfOption<bool> menu_on_middle_click{WfOptions::panel::tray_menu_on_middle_click};
 
     Glib::ustring dbus_name;
 
@@ -52,6 +52,9 @@ class StatusNotifierItem : public Gtk::EventBox
 
   public:
     explicit StatusNotifierItem(const Glib::ustring & service);
+
+    /* Handle a signal from an event log, see WfEventLog */
+    void handle_replayed_signal(const Glib::ustring & signal, const Glib::VariantContainerBase & params);
 };
 
 #endif
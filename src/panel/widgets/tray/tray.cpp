@@ -1,9 +1,50 @@
 #include "tray.hpp"
 
+#include <wf-event-log.hpp>
+
+WayfireStatusNotifier::~WayfireStatusNotifier()
+{
+    replay_conn.disconnect();
+}
+
 void WayfireStatusNotifier::init(Gtk::HBox *container)
 {
     icons_hbox.set_spacing(5);
     container->add(icons_hbox);
+
+    replay_conn = WfEventLog::replayed_sni_signal().connect(
+        sigc::mem_fun(this, &WayfireStatusNotifier::handle_replayed_signal));
+}
+
+void WayfireStatusNotifier::handle_replayed_signal(const Glib::ustring & service,
+    const Glib::ustring & signal, const Glib::VariantContainerBase & params)
+{
+    /* Signals of the watcher have no service */
+    if (service.empty())
+    {
+        if (!params.is_of_type(Glib::VariantType("(s)")))
+        {
+            return;
+        }
+
+        Glib::Variant<Glib::ustring> item_path;
+        params.get_child(item_path);
+        if (signal == "StatusNotifierItemRegistered")
+        {
+            add_item(item_path.get());
+        } else if (signal == "StatusNotifierItemUnregistered")
+        {
+            remove_item(item_path.get());
+        }
+
+        return;
+    }
+
+    auto it = items.find(service);
+    if (it != items.end())
+    {
+        it->second.handle_replayed_signal(signal, params);
+    }
 }
 
 void WayfireStatusNotifier::add_item(const Glib::ustring & service)
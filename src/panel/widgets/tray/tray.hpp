@@ -14,7 +14,12 @@ class WayfireStatusNotifier : public WayfireWidget
     Gtk::HBox icons_hbox;
     std::map<Glib::ustring, StatusNotifierItem> items;
 
+    sigc::connection replay_conn;
+    void handle_replayed_signal(const Glib::ustring & service, const Glib::ustring & signal,
+        const Glib::VariantContainerBase & params);
+
   public:
+    ~WayfireStatusNotifier();
     void init(Gtk::HBox *container) override;
 
     void add_item(const Glib::ustring & service);
@@ -3,6 +3,7 @@
 #include "volume.hpp"
 #include "launchers.hpp"
 #include "gtk-utils.hpp"
+#include <wf-stats.hpp>
 
 WayfireVolumeScale::WayfireVolumeScale()
 {
@@ -109,7 +110,7 @@ void WayfireVolume::check_set_popover_timeout()
         return;
     }
 
-    popover_timeout = Glib::signal_timeout().connect(sigc::bind(sigc::mem_fun(*this,
+    popover_timeout = WfStats::signal_timeout().connect(sigc::bind(sigc::mem_fun(*this,
         &WayfireVolume::on_popover_timeout), 0), timeout * 1000);
 }
 
@@ -159,6 +160,7 @@ void WayfireVolume::on_volume_button_press(GdkEventButton *event)
 
 void WayfireVolume::on_volume_changed_external()
 {
+    WfStatsScope scope{stats};
     auto volume = gvc_mixer_stream_get_volume(gvc_stream);
     if (volume != (pa_volume_t)this->volume_scale.get_target_value())
     {
@@ -175,6 +177,7 @@ void WayfireVolume::on_volume_changed_external()
 
 void WayfireVolume::on_muted_changed_external()
 {
+    WfStatsScope scope{stats};
     update_icon();
     button->set_keyboard_interactive(false);
     if (!button->get_popover()->is_visible())
@@ -218,6 +221,7 @@ void WayfireVolume::disconnect_gvc_stream_signals()
 
 void WayfireVolume::on_default_sink_changed()
 {
+    WfStatsScope scope{stats};
     gvc_stream = gvc_mixer_control_get_default_sink(gvc_control);
     if (!gvc_stream)
     {
@@ -36,9 +36,9 @@ class WayfireVolume : public WayfireWidget
     WayfireVolumeScale volume_scale;
     std::unique_ptr<WayfireMenuButton> button;
 
-    WfOption<int> icon_size{"panel/volume_icon_size"};
-    WfOption<double> timeout{"panel/volume_display_timeout"};
-    WfOption<double> scroll_sensitivity{"panel/volume_scroll_sensitivity"};
+    WfOption<int> icon_size{WfOptions::panel::volume_icon_size};
+    WfOption<double> timeout{WfOptions::panel::volume_display_timeout};
+    WfOption<double> scroll_sensitivity{WfOptions::panel::volume_scroll_sensitivity};
 
     void on_volume_scroll(GdkEventScroll *event);
     void on_volume_button_press(GdkEventButton *event);
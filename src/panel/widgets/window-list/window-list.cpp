@@ -1,6 +1,7 @@
 #include <iostream>
 #include <glibmm.h>
 #include <gdk/gdkwayland.h>
+#include <wf-event-log.hpp>
 
 #include "toplevel.hpp"
 #include "window-list.hpp"
@@ -143,51 +144,20 @@ zwlr_foreign_toplevel_manager_v1_listener toplevel_manager_v1_impl = {
     .finished = handle_manager_finished,
 };
 
-static void registry_add_object(void *data, wl_registry *registry, uint32_t name,
-    const char *interface, uint32_t version)
-{
-    WayfireWindowList *window_list = (WayfireWindowList*)data;
-    if (strcmp(interface, zwlr_foreign_toplevel_manager_v1_interface.name) == 0)
-    {
-        auto zwlr_toplevel_manager = (zwlr_foreign_toplevel_manager_v1*)
-            wl_registry_bind(registry, name,
-            &zwlr_foreign_toplevel_manager_v1_interface,
-            std::min(version, 3u));
-
-        window_list->handle_toplevel_manager(zwlr_toplevel_manager);
-    }
-}
-
-static void registry_remove_object(void *data, struct wl_registry *registry, uint32_t name)
-{}
-
-static struct wl_registry_listener registry_listener =
-{
-    &registry_add_object,
-    &registry_remove_object
-};
-
 void WayfireWindowList::init(Gtk::HBox *container)
 {
-    auto gdk_display = gdk_display_get_default();
-    auto display     = gdk_wayland_display_get_wl_display(gdk_display);
-
-    wl_registry *registry = wl_display_get_registry(display);
-    wl_registry_add_listener(registry, &registry_listener, this);
-    wl_display_roundtrip(display);
+    handle_toplevel_manager(WfEventLog::bind_toplevel_manager(
+        *WayfireShellApp::get().registry, 3));
 
     if (!this->manager)
     {
         std::cerr << "Compositor doesn't support" <<
             " wlr-foreign-toplevel-management." <<
             "The window-list widget will not be initialized." << std::endl;
-        wl_registry_destroy(registry);
         return;
     }
 
-    wl_registry_destroy(registry);
-    zwlr_foreign_toplevel_manager_v1_add_listener(manager,
-        &toplevel_manager_v1_impl, this);
+    WfEventLog::add_manager_listener(manager, &toplevel_manager_v1_impl, this);
 
     box.set_homogeneous(true);
     scrolled_window.add(box);
@@ -208,11 +178,13 @@ void WayfireWindowList::handle_toplevel_manager(zwlr_foreign_toplevel_manager_v1
 
 void WayfireWindowList::handle_new_toplevel(zwlr_foreign_toplevel_handle_v1 *handle)
 {
+    WfStatsScope scope{stats};
     toplevels[handle] = std::unique_ptr<WayfireToplevel>(new WayfireToplevel(this, handle));
 }
 
 void WayfireWindowList::handle_toplevel_closed(zwlr_foreign_toplevel_handle_v1 *handle)
 {
+    WfStatsScope scope{stats};
     toplevels.erase(handle);
 }
 
@@ -223,5 +195,5 @@ WayfireWindowList::WayfireWindowList(WayfireOutput *output)
 
 WayfireWindowList::~WayfireWindowList()
 {
-    zwlr_foreign_toplevel_manager_v1_destroy(manager);
+    WfEventLog::destroy_manager(manager);
 }
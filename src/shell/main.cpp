@@ -0,0 +1,15 @@
+#include "background.hpp"
+#include "panel.hpp"
+#include "dock.hpp"
+
+/* Runs the background, panel and dock in one process, sharing the config,
+ * the connection to the compositor and the icon cache */
+int main(int argc, char **argv)
+{
+    WayfireShellApp::create(argc, argv);
+    WayfireBackgroundApp::create();
+    WayfirePanelApp::create();
+    WfDockApp::create();
+    WayfireShellApp::get().run();
+    return 0;
+}
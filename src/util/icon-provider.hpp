@@ -0,0 +1,26 @@
+#ifndef WF_ICON_PROVIDER_HPP
+#define WF_ICON_PROVIDER_HPP
+
+#include <gtkmm/image.h>
+#include <string>
+
+/**
+ * Finds icons for toplevels by their app_id. Used by the window list of
+ * the panel and by the dock, which share the lookups when they run in the
+ * same process.
+ */
+namespace IconProvider
+{
+/* Loads custom app_id -> icon file mappings from the dock section.
+ * They have the format icon_mapping_<app_id> = <icon file>. The mappings
+ * are used by every caller in the process, so when the dock runs in
+ * wf-shell, they apply to the window list of the panel as well. */
+void load_custom_icons();
+
+/* Sets the image to the icon of the first app_id in the space separated
+ * list for which an icon can be found */
+void set_image_from_icon(Gtk::Image& image,
+    std::string app_id_list, int size, int scale);
+}
+
+#endif /* end of include guard: WF_ICON_PROVIDER_HPP */
@@ -3,6 +3,7 @@
 
 #include <gtk-layer-shell.h>
 #include <wf-shell-app.hpp>
+#include <wf-stats.hpp>
 #include <gdk/gdkwayland.h>
 
 #include <glibmm.h>
@@ -47,6 +48,9 @@ WayfireAutohidingWindow::WayfireAutohidingWindow(WayfireOutput *output,
 
     this->autohide_opt.set_callback([=] { setup_autohide(); });
 
+    reattached_conn = output->reattached_signal().connect(
+        [=] () { this->handle_output_reattached(); });
+
     if (!output->output)
     {
         std::cerr << "WARNING: Compositor does not support zwf_shell_manager_v2 " << \
@@ -55,25 +59,22 @@ WayfireAutohidingWindow::WayfireAutohidingWindow(WayfireOutput *output,
         return;
     }
 
-    static const zwf_output_v2_listener listener = {
-        .enter_fullscreen = [] (void *data, zwf_output_v2*)
-        {
-            ((WayfireAutohidingWindow*)data)->increase_autohide();
-        },
-        .leave_fullscreen = [] (void *data, zwf_output_v2*)
-        {
-            ((WayfireAutohidingWindow*)data)->decrease_autohide();
-        },
-        .toggle_menu = [] (void *data, zwf_output_v2*)
-        {
-            ((WayfireAutohidingWindow*)data)->output->toggle_menu_signal().emit();
-        },
-    };
-    zwf_output_v2_add_listener(output->output, &listener, this);
+    enter_fullscreen_conn = output->enter_fullscreen_signal().connect(
+        [=] () { this->increase_autohide(); });
+    leave_fullscreen_conn = output->leave_fullscreen_signal().connect(
+        [=] () { this->decrease_autohide(); });
+    if (output->fullscreen)
+    {
+        this->increase_autohide();
+    }
 }
 
 WayfireAutohidingWindow::~WayfireAutohidingWindow()
 {
+    enter_fullscreen_conn.disconnect();
+    leave_fullscreen_conn.disconnect();
+    reattached_conn.disconnect();
+
     if (this->edge_hotspot)
     {
         zwf_hotspot_v2_destroy(this->edge_hotspot);
@@ -85,6 +86,32 @@ WayfireAutohidingWindow::~WayfireAutohidingWindow()
     }
 }
 
+void WayfireAutohidingWindow::handle_output_reattached()
+{
+    /* The layer surface is mapped again on the new monitor */
+    gtk_layer_set_monitor(this->gobj(), output->monitor->gobj());
+
+    /* The hotspots belonged to the old output, so they have to be
+     * created again */
+    if (this->edge_hotspot)
+    {
+        zwf_hotspot_v2_destroy(edge_hotspot);
+        this->edge_hotspot = NULL;
+    }
+
+    if (this->panel_hotspot)
+    {
+        zwf_hotspot_v2_destroy(panel_hotspot);
+        this->panel_hotspot = NULL;
+    }
+
+    this->last_hotspot_height = -1;
+    if (output->output && autohide_opt)
+    {
+        setup_hotspot();
+    }
+}
+
 wl_surface*WayfireAutohidingWindow::get_wl_surface() const
 {
     auto gdk_window = const_cast<GdkWindow*>(this->get_window()->gobj());
@@ -130,7 +157,7 @@ void WayfireAutohidingWindow::m_show_uncertain()
     /* And don't forget to hide the window afterwards, if autohide is enabled */
     if (should_autohide())
     {
-        pending_hide = Glib::signal_timeout().connect([=] ()
+        pending_hide = WfStats::signal_timeout().connect([=] ()
         {
             schedule_hide(0);
             return false;
@@ -354,7 +381,7 @@ void WayfireAutohidingWindow::schedule_hide(int delay)
 
     if (!pending_hide.connected())
     {
-        pending_hide = Glib::signal_timeout().connect(
+        pending_hide = WfStats::signal_timeout().connect(
             sigc::mem_fun(this, &WayfireAutohidingWindow::m_do_hide), delay);
     }
 }
@@ -377,7 +404,7 @@ void WayfireAutohidingWindow::schedule_show(int delay)
 
     if (!pending_show.connected())
     {
-        pending_show = Glib::signal_timeout().connect(
+        pending_show = WfStats::signal_timeout().connect(
             sigc::mem_fun(this, &WayfireAutohidingWindow::m_do_show), delay);
     }
 }
@@ -119,6 +119,11 @@ class WayfireAutohidingWindow : public Gtk::Window
     std::unique_ptr<WayfireAutohidingWindowHotspotCallbacks> panel_callbacks;
     void setup_hotspot();
 
+    sigc::connection enter_fullscreen_conn, leave_fullscreen_conn;
+    /* Moves the window to the new monitor of its output */
+    sigc::connection reattached_conn;
+    void handle_output_reattached();
+
     sigc::connection popover_hide;
     WayfireMenuButton *active_button = nullptr;
 };
@@ -0,0 +1,630 @@
+#include <glib.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include <libxml/tree.h>
+#include <wayfire/config/compound-option.hpp>
+#include <wayfire/config/file.hpp>
+#include <wayfire/config/types.hpp>
+#include <wayfire/config/xml.hpp>
+
+#include "wf-config-cache.hpp"
+
+#define CONFIG_CACHE_MAGIC   "WFSCHEMA"
+#define CONFIG_CACHE_VERSION 1
+
+namespace
+{
+/* The option types which can be restored from the snapshot. If the
+ * metadata contains any other type, no snapshot is written. */
+enum type_t : uint8_t
+{
+    TYPE_INT,
+    TYPE_BOOL,
+    TYPE_DOUBLE,
+    TYPE_STRING,
+    TYPE_COLOR,
+    TYPE_DYNAMIC_LIST,
+};
+
+/* An entry of a dynamic list */
+struct cached_entry_t
+{
+    uint8_t type;
+    std::string prefix, name, default_value;
+};
+
+struct cached_option_t
+{
+    uint8_t type;
+    std::string name;
+    std::string default_value;
+    bool has_minimum = false, has_maximum = false;
+    std::string minimum, maximum;
+
+    /* Only for dynamic lists */
+    std::string type_hint;
+    std::vector<cached_entry_t> entries;
+};
+
+struct cached_section_t
+{
+    std::string name;
+    std::vector<cached_option_t> options;
+};
+
+std::string get_cache_path()
+{
+    std::string cache_dir;
+
+    char *cache_home = getenv("XDG_CACHE_HOME");
+    if (cache_home == NULL)
+    {
+        cache_dir = std::string(getenv("HOME")) + "/.cache";
+    } else
+    {
+        cache_dir = std::string(cache_home);
+    }
+
+    return cache_dir + "/wf-shell/config-schema.bin";
+}
+
+void append_file_key(std::ostringstream& out, const std::string& path)
+{
+    struct stat st;
+    out << path << '\n';
+    if (stat(path.c_str(), &st) == 0)
+    {
+        out << st.st_mtim.tv_sec << '.' << st.st_mtim.tv_nsec << ' ' <<
+            st.st_size << '\n';
+    } else
+    {
+        out << "missing\n";
+    }
+}
+
+/* The key identifies the versions of all files the schema is built from */
+std::string get_key(const std::vector<std::string>& xmldirs,
+    const std::string& sysconf_file)
+{
+    std::ostringstream out;
+    for (auto& dir : xmldirs)
+    {
+        std::vector<std::string> files;
+        auto d = opendir(dir.c_str());
+        if (d)
+        {
+            dirent *file;
+            while ((file = readdir(d)) != 0)
+            {
+                std::string name = file->d_name;
+                if ((name.size() > 4) && (name.compare(name.size() - 4, 4, ".xml") == 0))
+                {
+                    files.push_back(dir + "/" + name);
+                }
+            }
+
+            closedir(d);
+        }
+
+        std::sort(files.begin(), files.end());
+        out << dir << ' ' << files.size() << '\n';
+        for (auto& file : files)
+        {
+            append_file_key(out, file);
+        }
+    }
+
+    append_file_key(out, sysconf_file);
+    return out.str();
+}
+
+bool parse_type(const std::string& name, uint8_t& type)
+{
+    static const std::pair<const char*, type_t> types[] = {
+        {"int", TYPE_INT},
+        {"bool", TYPE_BOOL},
+        {"double", TYPE_DOUBLE},
+        {"string", TYPE_STRING},
+        {"color", TYPE_COLOR},
+        {"dynamic-list", TYPE_DYNAMIC_LIST},
+    };
+
+    for (auto& t : types)
+    {
+        if (name == t.first)
+        {
+            type = t.second;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+std::string get_prop(xmlNode *node, const char *name)
+{
+    auto value = xmlGetProp(node, (const xmlChar*)name);
+    if (!value)
+    {
+        return "";
+    }
+
+    std::string result = (const char*)value;
+    xmlFree(value);
+    return result;
+}
+
+/* Get the text of the first child element with the given name */
+bool get_child_text(xmlNode *node, const char *name, std::string& text)
+{
+    for (auto child = node->children; child; child = child->next)
+    {
+        if ((child->type == XML_ELEMENT_NODE) &&
+            !xmlStrcmp(child->name, (const xmlChar*)name))
+        {
+            auto content = xmlNodeGetContent(child);
+            text = content ? (const char*)content : "";
+            xmlFree(content);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool snapshot_option(const std::shared_ptr<wf::config::option_base_t>& option,
+    xmlNode *node, cached_option_t& cached)
+{
+    if (!parse_type(get_prop(node, "type"), cached.type))
+    {
+        return false;
+    }
+
+    cached.name = option->get_name();
+    if (cached.type != TYPE_DYNAMIC_LIST)
+    {
+        cached.default_value = option->get_default_value_str();
+        cached.has_minimum   = get_child_text(node, "min", cached.minimum);
+        cached.has_maximum   = get_child_text(node, "max", cached.maximum);
+        return true;
+    }
+
+    cached.type_hint = get_prop(node, "type-hint");
+    if (cached.type_hint.empty())
+    {
+        cached.type_hint = "plain";
+    }
+
+    for (auto child = node->children; child; child = child->next)
+    {
+        if ((child->type != XML_ELEMENT_NODE) ||
+            xmlStrcmp(child->name, (const xmlChar*)"entry"))
+        {
+            continue;
+        }
+
+        cached_entry_t entry;
+        if (!parse_type(get_prop(child, "type"), entry.type) ||
+            (entry.type == TYPE_DYNAMIC_LIST))
+        {
+            return false;
+        }
+
+        entry.prefix = get_prop(child, "prefix");
+        entry.name   = get_prop(child, "name");
+        get_child_text(child, "default", entry.default_value);
+        cached.entries.push_back(entry);
+    }
+
+    return true;
+}
+
+/* Snapshot the options which were created from the metadata files. Options
+ * which only exist in the user's config file are skipped, they are created
+ * again when it is loaded. */
+bool take_snapshot(wf::config::config_manager_t& config,
+    std::vector<cached_section_t>& sections)
+{
+    for (auto& section : config.get_all_sections())
+    {
+        if (!wf::config::xml::get_section_xml_node(section))
+        {
+            continue;
+        }
+
+        cached_section_t cached_section;
+        cached_section.name = section->get_name();
+        for (auto& option : section->get_registered_options())
+        {
+            auto node = wf::config::xml::get_option_xml_node(option);
+            if (!node)
+            {
+                continue;
+            }
+
+            cached_option_t cached;
+            if (!snapshot_option(option, node, cached))
+            {
+                return false;
+            }
+
+            cached_section.options.push_back(std::move(cached));
+        }
+
+        sections.push_back(std::move(cached_section));
+    }
+
+    return true;
+}
+
+struct writer_t
+{
+    std::string data;
+
+    void u8(uint8_t value)
+    {
+        data += (char)value;
+    }
+
+    void u32(uint32_t value)
+    {
+        data.append((const char*)&value, sizeof(value));
+    }
+
+    void str(const std::string& value)
+    {
+        u32(value.size());
+        data += value;
+    }
+};
+
+/* Reads the snapshot, ok is cleared if the data is truncated */
+struct reader_t
+{
+    const std::string& data;
+    size_t pos = 0;
+    bool ok    = true;
+
+    uint8_t u8()
+    {
+        if (!ok || (pos + 1 > data.size()))
+        {
+            ok = false;
+            return 0;
+        }
+
+        return data[pos++];
+    }
+
+    uint32_t u32()
+    {
+        uint32_t value = 0;
+        if (!ok || (pos + sizeof(value) > data.size()))
+        {
+            ok = false;
+            return 0;
+        }
+
+        memcpy(&value, data.data() + pos, sizeof(value));
+        pos += sizeof(value);
+        return value;
+    }
+
+    /* A number of elements, each of which takes at least one byte */
+    uint32_t count()
+    {
+        uint32_t value = u32();
+        if (value > data.size() - pos)
+        {
+            ok = false;
+            return 0;
+        }
+
+        return value;
+    }
+
+    std::string str()
+    {
+        uint32_t size = u32();
+        if (!ok || (pos + size > data.size()))
+        {
+            ok = false;
+            return "";
+        }
+
+        pos += size;
+        return data.substr(pos - size, size);
+    }
+};
+
+void store_snapshot(const std::string& key,
+    const std::vector<cached_section_t>& sections)
+{
+    writer_t writer;
+    writer.data = std::string(CONFIG_CACHE_MAGIC, strlen(CONFIG_CACHE_MAGIC));
+    writer.u32(CONFIG_CACHE_VERSION);
+    writer.str(key);
+
+    writer.u32(sections.size());
+    for (auto& section : sections)
+    {
+        writer.str(section.name);
+        writer.u32(section.options.size());
+        for (auto& option : section.options)
+        {
+            writer.u8(option.type);
+            writer.str(option.name);
+            writer.str(option.default_value);
+            writer.u8(option.has_minimum);
+            writer.str(option.minimum);
+            writer.u8(option.has_maximum);
+            writer.str(option.maximum);
+            writer.str(option.type_hint);
+            writer.u32(option.entries.size());
+            for (auto& entry : option.entries)
+            {
+                writer.u8(entry.type);
+                writer.str(entry.prefix);
+                writer.str(entry.name);
+                writer.str(entry.default_value);
+            }
+        }
+    }
+
+    auto path = get_cache_path();
+    auto dir  = path.substr(0, path.rfind('/'));
+    if (g_mkdir_with_parents(dir.c_str(), 0700) != 0)
+    {
+        return;
+    }
+
+    /* The shell components start at the same time, so they may all write
+     * the snapshot at once. Readers never see a partially written one. */
+    auto tmp_path = path + ".XXXXXX";
+    int fd = mkostemp(&tmp_path[0], O_CLOEXEC);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    bool ok = (write(fd, writer.data.data(), writer.data.size()) ==
+        (ssize_t)writer.data.size());
+    close(fd);
+
+    if (!ok || (rename(tmp_path.c_str(), path.c_str()) != 0))
+    {
+        unlink(tmp_path.c_str());
+    }
+}
+
+bool load_snapshot(const std::string& key, std::vector<cached_section_t>& sections)
+{
+    std::ifstream in(get_cache_path(), std::ios::binary);
+    if (!in)
+    {
+        return false;
+    }
+
+    std::string data{std::istreambuf_iterator<char>(in),
+        std::istreambuf_iterator<char>()};
+    size_t magic_length = strlen(CONFIG_CACHE_MAGIC);
+    if (data.compare(0, magic_length, CONFIG_CACHE_MAGIC) != 0)
+    {
+        return false;
+    }
+
+    reader_t reader{data};
+    reader.pos = magic_length;
+    if ((reader.u32() != CONFIG_CACHE_VERSION) || (reader.str() != key))
+    {
+        return false;
+    }
+
+    sections.resize(reader.count());
+    for (auto& section : sections)
+    {
+        section.name = reader.str();
+        section.options.resize(reader.count());
+        for (auto& option : section.options)
+        {
+            option.type = reader.u8();
+            option.name = reader.str();
+            option.default_value = reader.str();
+            option.has_minimum   = reader.u8();
+            option.minimum = reader.str();
+            option.has_maximum = reader.u8();
+            option.maximum     = reader.str();
+            option.type_hint   = reader.str();
+            option.entries.resize(reader.count());
+            for (auto& entry : option.entries)
+            {
+                entry.type   = reader.u8();
+                entry.prefix = reader.str();
+                entry.name   = reader.str();
+                entry.default_value = reader.str();
+            }
+
+            if (!reader.ok)
+            {
+                return false;
+            }
+        }
+    }
+
+    return reader.ok && (reader.pos == data.size());
+}
+
+template<class Type>
+std::shared_ptr<wf::config::option_base_t> create_option(const cached_option_t& cached)
+{
+    auto value = wf::option_type::from_string<Type>(cached.default_value);
+    if (!value)
+    {
+        return nullptr;
+    }
+
+    return std::make_shared<wf::config::option_t<Type>>(cached.name, value.value());
+}
+
+template<class Type>
+std::shared_ptr<wf::config::option_base_t> create_bounded_option(
+    const cached_option_t& cached)
+{
+    auto value = wf::option_type::from_string<Type>(cached.default_value);
+    if (!value)
+    {
+        return nullptr;
+    }
+
+    auto option = std::make_shared<wf::config::option_t<Type>>(cached.name, value.value());
+    if (cached.has_minimum)
+    {
+        if (auto minimum = wf::option_type::from_string<Type>(cached.minimum))
+        {
+            option->set_minimum(minimum.value());
+        }
+    }
+
+    if (cached.has_maximum)
+    {
+        if (auto maximum = wf::option_type::from_string<Type>(cached.maximum))
+        {
+            option->set_maximum(maximum.value());
+        }
+    }
+
+    return option;
+}
+
+template<class Type>
+std::unique_ptr<wf::config::compound_option_entry_base_t> create_entry(
+    const cached_entry_t& entry)
+{
+    return std::make_unique<wf::config::compound_option_entry_t<Type>>(
+        entry.prefix, entry.name, entry.default_value);
+}
+
+std::shared_ptr<wf::config::option_base_t> create_dynamic_list(
+    const cached_option_t& cached)
+{
+    wf::config::compound_option_t::entries_t entries;
+    for (auto& entry : cached.entries)
+    {
+        switch (entry.type)
+        {
+          case TYPE_INT:
+            entries.push_back(create_entry<int>(entry));
+            break;
+
+          case TYPE_BOOL:
+            entries.push_back(create_entry<bool>(entry));
+            break;
+
+          case TYPE_DOUBLE:
+            entries.push_back(create_entry<double>(entry));
+            break;
+
+          case TYPE_STRING:
+            entries.push_back(create_entry<std::string>(entry));
+            break;
+
+          case TYPE_COLOR:
+            entries.push_back(create_entry<wf::color_t>(entry));
+            break;
+
+          default:
+            return nullptr;
+        }
+    }
+
+    return std::make_shared<wf::config::compound_option_t>(cached.name,
+        std::move(entries), cached.type_hint);
+}
+
+std::shared_ptr<wf::config::option_base_t> create_option(const cached_option_t& cached)
+{
+    switch (cached.type)
+    {
+      case TYPE_INT:
+        return create_bounded_option<int>(cached);
+
+      case TYPE_BOOL:
+        return create_option<bool>(cached);
+
+      case TYPE_DOUBLE:
+        return create_bounded_option<double>(cached);
+
+      case TYPE_STRING:
+        return create_option<std::string>(cached);
+
+      case TYPE_COLOR:
+        return create_option<wf::color_t>(cached);
+
+      case TYPE_DYNAMIC_LIST:
+        return create_dynamic_list(cached);
+
+      default:
+        return nullptr;
+    }
+}
+
+bool restore_snapshot(const std::vector<cached_section_t>& sections,
+    wf::config::config_manager_t& config)
+{
+    for (auto& cached_section : sections)
+    {
+        auto section = std::make_shared<wf::config::section_t>(cached_section.name);
+        for (auto& cached : cached_section.options)
+        {
+            auto option = create_option(cached);
+            if (!option)
+            {
+                return false;
+            }
+
+            section->register_new_option(option);
+        }
+
+        config.add_section(section);
+    }
+
+    return true;
+}
+}
+
+wf::config::config_manager_t WfConfigCache::build_configuration(
+    const std::vector<std::string>& xmldirs, const std::string& sysconf_file,
+    const std::string& user_file)
+{
+    auto key = get_key(xmldirs, sysconf_file);
+
+    std::vector<cached_section_t> sections;
+    if (load_snapshot(key, sections))
+    {
+        wf::config::config_manager_t config;
+        if (restore_snapshot(sections, config))
+        {
+            wf::config::load_configuration_options_from_file(config, user_file);
+            return config;
+        }
+    }
+
+    auto config = wf::config::build_configuration(xmldirs, sysconf_file, user_file);
+
+    sections.clear();
+    if (take_snapshot(config, sections))
+    {
+        store_snapshot(key, sections);
+    }
+
+    return config;
+}
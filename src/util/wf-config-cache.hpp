@@ -0,0 +1,27 @@
+#ifndef WF_CONFIG_CACHE_HPP
+#define WF_CONFIG_CACHE_HPP
+
+#include <string>
+#include <vector>
+#include <wayfire/config/config-manager.hpp>
+
+/**
+ * A snapshot of the options declared in the metadata files, with the
+ * defaults from the system defaults file already applied, stored in
+ * $XDG_CACHE_HOME/wf-shell/config-schema.bin.
+ *
+ * On warm starts the options are created from the snapshot, so that only
+ * the user's config file has to be parsed. The snapshot is keyed by the
+ * paths, mtimes and sizes of the metadata files and the defaults file, so
+ * installing new metadata invalidates it.
+ */
+namespace WfConfigCache
+{
+/* A drop-in replacement for wf::config::build_configuration() which uses
+ * the snapshot when it is up to date, and writes it otherwise */
+wf::config::config_manager_t build_configuration(
+    const std::vector<std::string>& xmldirs, const std::string& sysconf_file,
+    const std::string& user_file);
+}
+
+#endif /* end of include guard: WF_CONFIG_CACHE_HPP */
@@ -0,0 +1,922 @@
+#include <gdk/gdkwayland.h>
+#include <gdkmm/display.h>
+#include <glibmm/main.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "wf-event-log.hpp"
+#include "wf-registry.hpp"
+#include "wf-stats.hpp"
+#include "wf-trace.hpp"
+
+#define EVENT_LOG_MAGIC   "WFEVLOG"
+#define EVENT_LOG_VERSION 1
+/* Recorded events are written directly above this size, otherwise when the
+ * main loop is idle */
+#define EVENT_LOG_BUFFER_SIZE (64 * 1024)
+
+namespace
+{
+enum event_type_t : uint8_t
+{
+    TOPLEVEL_NEW,
+    TOPLEVEL_TITLE,
+    TOPLEVEL_APP_ID,
+    TOPLEVEL_OUTPUT_ENTER,
+    TOPLEVEL_OUTPUT_LEAVE,
+    TOPLEVEL_STATE,
+    TOPLEVEL_DONE,
+    TOPLEVEL_CLOSED,
+    TOPLEVEL_PARENT,
+    NOTIFY,
+    SNI_SIGNAL,
+};
+
+/*
+ * The log starts with the magic and the version. Each event is the time
+ * since the previous event in microseconds, its type and its arguments.
+ * Numbers are stored as varints and strings with their length first.
+ * Toplevels are identified by the order in which they were created.
+ */
+void put_varint(std::string& out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out += (char)((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+
+    out += (char)value;
+}
+
+void put_string(std::string& out, const std::string& value)
+{
+    put_varint(out, value.size());
+    out += value;
+}
+
+void put_variant(std::string& out, const Glib::VariantBase& value)
+{
+    put_string(out, value.get_type_string());
+    put_string(out, std::string((const char*)value.get_data(), value.get_size()));
+}
+
+/* Reads the log, ok is cleared if the data is truncated or invalid */
+struct reader_t
+{
+    std::string data;
+    size_t pos = 0;
+    bool ok    = true;
+
+    bool at_end() const
+    {
+        return !ok || (pos >= data.size());
+    }
+
+    uint64_t varint()
+    {
+        uint64_t value = 0;
+        for (int shift = 0; ok && (shift < 64); shift += 7)
+        {
+            if (pos >= data.size())
+            {
+                break;
+            }
+
+            uint8_t byte = data[pos++];
+            value |= (uint64_t)(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+            {
+                return value;
+            }
+        }
+
+        ok = false;
+        return 0;
+    }
+
+    std::string str()
+    {
+        uint64_t size = varint();
+        if (!ok || (size > data.size() - pos))
+        {
+            ok = false;
+            return "";
+        }
+
+        pos += size;
+        return data.substr(pos - size, size);
+    }
+
+    Glib::VariantContainerBase variant()
+    {
+        auto type = str();
+        auto value_data = str();
+        if (!ok || !g_variant_type_string_is_valid(type.c_str()) ||
+            !g_variant_type_is_container(G_VARIANT_TYPE(type.c_str())))
+        {
+            ok = false;
+            return {};
+        }
+
+        /* Untrusted, so that corrupt data is replaced by default values */
+        auto bytes = g_bytes_new(value_data.data(), value_data.size());
+        auto value = g_variant_new_from_bytes(G_VARIANT_TYPE(type.c_str()), bytes, false);
+        g_bytes_unref(bytes);
+        return Glib::VariantContainerBase(g_variant_ref_sink(value), false);
+    }
+};
+
+/* Outputs are identified by the index of their monitor, starting at 1 */
+uint64_t get_output_index(wl_output *output)
+{
+    auto display = Gdk::Display::get_default();
+    for (int i = 0; i < display->get_n_monitors(); i++)
+    {
+        if (gdk_wayland_monitor_get_wl_output(display->get_monitor(i)->gobj()) == output)
+        {
+            return i + 1;
+        }
+    }
+
+    return 0;
+}
+
+wl_output *get_output(uint64_t index)
+{
+    auto display = Gdk::Display::get_default();
+    if ((index == 0) || (index > (uint64_t)display->get_n_monitors()))
+    {
+        return nullptr;
+    }
+
+    return gdk_wayland_monitor_get_wl_output(display->get_monitor(index - 1)->gobj());
+}
+
+sigc::signal<void(Glib::ustring, Glib::VariantContainerBase)> notify_signal;
+sigc::signal<void(Glib::ustring, Glib::ustring, Glib::VariantContainerBase)> sni_signal;
+
+/* Recording */
+bool is_recording = false;
+std::ofstream record_out;
+std::string pending;
+bool flush_scheduled = false;
+gint64 last_event_time = 0;
+
+bool flush_events()
+{
+    record_out.write(pending.data(), pending.size());
+    record_out.flush();
+    pending.clear();
+    flush_scheduled = false;
+    return false;
+}
+
+/* Start an event, the arguments are appended to the returned buffer */
+std::string& begin_event(event_type_t type)
+{
+    if (pending.size() > EVENT_LOG_BUFFER_SIZE)
+    {
+        record_out.write(pending.data(), pending.size());
+        pending.clear();
+    }
+
+    auto now = g_get_monotonic_time();
+    put_varint(pending, last_event_time ? now - last_event_time : 0);
+    last_event_time = now;
+    pending += (char)type;
+
+    if (!flush_scheduled)
+    {
+        flush_scheduled = true;
+        Glib::signal_idle().connect(&flush_events, Glib::PRIORITY_LOW);
+    }
+
+    return pending;
+}
+
+/* Every manager is wrapped, but only the events of the first live one are
+ * recorded. The compositor sends the same events to every manager, and so
+ * does the replay. When that manager is destroyed, the next one takes over. */
+struct recorded_manager_t
+{
+    zwlr_foreign_toplevel_manager_v1 *manager;
+    const zwlr_foreign_toplevel_manager_v1_listener *listener;
+    void *data;
+};
+
+std::list<recorded_manager_t> recorded_managers;
+
+bool is_recorded(const recorded_manager_t *manager)
+{
+    return !recorded_managers.empty() && (&recorded_managers.front() == manager);
+}
+
+struct recorded_toplevel_t
+{
+    uint64_t id;
+    recorded_manager_t *manager;
+    const zwlr_foreign_toplevel_handle_v1_listener *listener = nullptr;
+    void *data = nullptr;
+
+    /* The last known state, to announce the toplevel again when its
+     * manager takes over the recording */
+    std::string title, app_id;
+    std::vector<wl_output*> outputs;
+    std::vector<uint32_t> state;
+    zwlr_foreign_toplevel_handle_v1 *parent = nullptr;
+};
+
+std::map<zwlr_foreign_toplevel_handle_v1*, recorded_toplevel_t> recorded_toplevels;
+uint64_t next_toplevel_id = 1;
+
+/* Begin an event of the toplevel, if it belongs to the recorded manager */
+bool record_toplevel_event(event_type_t type, const recorded_toplevel_t& toplevel)
+{
+    if (!is_recorded(toplevel.manager))
+    {
+        return false;
+    }
+
+    put_varint(begin_event(type), toplevel.id);
+    return true;
+}
+
+uint64_t get_toplevel_id(zwlr_foreign_toplevel_handle_v1 *handle)
+{
+    auto it = recorded_toplevels.find(handle);
+    return it != recorded_toplevels.end() ? it->second.id : 0;
+}
+
+void put_state(const std::vector<uint32_t>& state)
+{
+    put_varint(pending, state.size());
+    for (auto s : state)
+    {
+        put_varint(pending, s);
+    }
+}
+
+/* Record the toplevels of the manager which now takes over the recording,
+ * as if they had just been created */
+void announce_toplevels(recorded_manager_t *manager)
+{
+    std::vector<recorded_toplevel_t*> toplevels;
+    for (auto& toplevel : recorded_toplevels)
+    {
+        if (toplevel.second.manager == manager)
+        {
+            toplevels.push_back(&toplevel.second);
+        }
+    }
+
+    std::sort(toplevels.begin(), toplevels.end(),
+        [] (auto a, auto b) { return a->id < b->id; });
+    for (auto toplevel : toplevels)
+    {
+        record_toplevel_event(TOPLEVEL_NEW, *toplevel);
+        record_toplevel_event(TOPLEVEL_TITLE, *toplevel);
+        put_string(pending, toplevel->title);
+        record_toplevel_event(TOPLEVEL_APP_ID, *toplevel);
+        put_string(pending, toplevel->app_id);
+        for (auto output : toplevel->outputs)
+        {
+            record_toplevel_event(TOPLEVEL_OUTPUT_ENTER, *toplevel);
+            put_varint(pending, get_output_index(output));
+        }
+
+        record_toplevel_event(TOPLEVEL_STATE, *toplevel);
+        put_state(toplevel->state);
+    }
+
+    /* Parents may have been created after their children */
+    for (auto toplevel : toplevels)
+    {
+        if (toplevel->parent)
+        {
+            record_toplevel_event(TOPLEVEL_PARENT, *toplevel);
+            put_varint(pending, get_toplevel_id(toplevel->parent));
+        }
+
+        record_toplevel_event(TOPLEVEL_DONE, *toplevel);
+    }
+}
+
+/* Records the events of a toplevel before passing them to the listener of
+ * the component */
+const zwlr_foreign_toplevel_handle_v1_listener recording_toplevel_listener = {
+    .title = [] (void *data, zwlr_foreign_toplevel_handle_v1 *handle, const char *title)
+    {
+        auto toplevel = (recorded_toplevel_t*)data;
+        toplevel->title = title;
+        if (record_toplevel_event(TOPLEVEL_TITLE, *toplevel))
+        {
+            put_string(pending, title);
+        }
+
+        toplevel->listener->title(toplevel->data, handle, title);
+    },
+    .app_id = [] (void *data, zwlr_foreign_toplevel_handle_v1 *handle, const char *app_id)
+    {
+        auto toplevel = (recorded_toplevel_t*)data;
+        toplevel->app_id = app_id;
+        if (record_toplevel_event(TOPLEVEL_APP_ID, *toplevel))
+        {
+            put_string(pending, app_id);
+        }
+
+        toplevel->listener->app_id(toplevel->data, handle, app_id);
+    },
+    .output_enter = [] (void *data, zwlr_foreign_toplevel_handle_v1 *handle, wl_output *output)
+    {
+        auto toplevel = (recorded_toplevel_t*)data;
+        toplevel->outputs.push_back(output);
+        if (record_toplevel_event(TOPLEVEL_OUTPUT_ENTER, *toplevel))
+        {
+            put_varint(pending, get_output_index(output));
+        }
+
+        toplevel->listener->output_enter(toplevel->data, handle, output);
+    },
+    .output_leave = [] (void *data, zwlr_foreign_toplevel_handle_v1 *handle, wl_output *output)
+    {
+        auto toplevel = (recorded_toplevel_t*)data;
+        auto& outputs = toplevel->outputs;
+        outputs.erase(std::remove(outputs.begin(), outputs.end(), output), outputs.end());
+        if (record_toplevel_event(TOPLEVEL_OUTPUT_LEAVE, *toplevel))
+        {
+            put_varint(pending, get_output_index(output));
+        }
+
+        toplevel->listener->output_leave(toplevel->data, handle, output);
+    },
+    .state = [] (void *data, zwlr_foreign_toplevel_handle_v1 *handle, wl_array *state)
+    {
+        auto toplevel = (recorded_toplevel_t*)data;
+        auto states = (uint32_t*)state->data;
+        toplevel->state.assign(states, states + state->size / sizeof(uint32_t));
+        if (record_toplevel_event(TOPLEVEL_STATE, *toplevel))
+        {
+            put_state(toplevel->state);
+        }
+
+        toplevel->listener->state(toplevel->data, handle, state);
+    },
+    .done = [] (void *data, zwlr_foreign_toplevel_handle_v1 *handle)
+    {
+        auto toplevel = (recorded_toplevel_t*)data;
+        record_toplevel_event(TOPLEVEL_DONE, *toplevel);
+        toplevel->listener->done(toplevel->data, handle);
+    },
+    .closed = [] (void *data, zwlr_foreign_toplevel_handle_v1 *handle)
+    {
+        /* The component destroys the handle when it is closed */
+        auto toplevel = *(recorded_toplevel_t*)data;
+        record_toplevel_event(TOPLEVEL_CLOSED, toplevel);
+        recorded_toplevels.erase(handle);
+        toplevel.listener->closed(toplevel.data, handle);
+    },
+    .parent = [] (void *data, zwlr_foreign_toplevel_handle_v1 *handle,
+                  zwlr_foreign_toplevel_handle_v1 *parent)
+    {
+        auto toplevel = (recorded_toplevel_t*)data;
+        toplevel->parent = parent;
+        if (record_toplevel_event(TOPLEVEL_PARENT, *toplevel))
+        {
+            put_varint(pending, get_toplevel_id(parent));
+        }
+
+        if (toplevel->listener->parent)
+        {
+            toplevel->listener->parent(toplevel->data, handle, parent);
+        }
+    },
+};
+
+const zwlr_foreign_toplevel_manager_v1_listener recording_manager_listener = {
+    .toplevel = [] (void *data, zwlr_foreign_toplevel_manager_v1 *manager,
+                    zwlr_foreign_toplevel_handle_v1 *handle)
+    {
+        auto recorded = (recorded_manager_t*)data;
+        auto& toplevel = recorded_toplevels[handle] = {next_toplevel_id++, recorded};
+        record_toplevel_event(TOPLEVEL_NEW, toplevel);
+        recorded->listener->toplevel(recorded->data, manager, handle);
+    },
+    .finished = [] (void *data, zwlr_foreign_toplevel_manager_v1 *manager)
+    {
+        auto recorded = (recorded_manager_t*)data;
+        recorded->listener->finished(recorded->data, manager);
+    },
+};
+
+/* Replay */
+bool is_replaying = false;
+bool replay_max_speed = false;
+reader_t replay_log;
+
+/* The managers are created on a display which is not connected to a
+ * compositor. Their requests are discarded. */
+wl_display *replay_display = nullptr;
+
+struct replay_manager_t
+{
+    wl_proxy *proxy;
+    uint32_t version;
+};
+
+std::vector<replay_manager_t> replay_managers;
+
+/* The handles of each replayed toplevel, one for every manager */
+struct replay_handle_t
+{
+    wl_proxy *manager;
+    uint32_t version;
+    wl_proxy *handle;
+};
+
+std::map<uint64_t, std::vector<replay_handle_t>> replay_toplevels;
+
+gint64 replay_start = 0;
+gint64 replay_time  = 0;
+rusage replay_usage;
+size_t replayed_events = 0;
+
+void connect_replay_display()
+{
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0)
+    {
+        perror("Failed to create the replay display");
+        std::exit(-1);
+    }
+
+    replay_display = wl_display_connect_to_fd(fds[0]);
+    Glib::signal_io().connect([fd = fds[1]] (Glib::IOCondition)
+    {
+        char buf[4096];
+        return read(fd, buf, sizeof(buf)) > 0;
+    }, fds[1], Glib::IO_IN | Glib::IO_HUP);
+}
+
+/* Call func with the listener and user data of each handle of the toplevel
+ * with the given id */
+template<class Func>
+void for_each_handle(uint64_t id, Func func)
+{
+    auto it = replay_toplevels.find(id);
+    if (it == replay_toplevels.end())
+    {
+        return;
+    }
+
+    /* The callbacks may change the toplevels */
+    auto handles = it->second;
+    for (auto& handle : handles)
+    {
+        auto listener = (const zwlr_foreign_toplevel_handle_v1_listener*)
+            wl_proxy_get_listener(handle.handle);
+        if (listener)
+        {
+            func(listener, wl_proxy_get_user_data(handle.handle),
+                (zwlr_foreign_toplevel_handle_v1*)handle.handle, handle);
+        }
+    }
+}
+
+void replay_new_toplevel(uint64_t id)
+{
+    for (auto& manager : std::vector<replay_manager_t>(replay_managers))
+    {
+        auto listener = (const zwlr_foreign_toplevel_manager_v1_listener*)
+            wl_proxy_get_listener(manager.proxy);
+        if (!listener)
+        {
+            continue;
+        }
+
+        auto handle = wl_proxy_create(manager.proxy, &zwlr_foreign_toplevel_handle_v1_interface);
+        replay_toplevels[id].push_back({manager.proxy, manager.version, handle});
+        listener->toplevel(wl_proxy_get_user_data(manager.proxy),
+            (zwlr_foreign_toplevel_manager_v1*)manager.proxy,
+            (zwlr_foreign_toplevel_handle_v1*)handle);
+    }
+}
+
+void replay_output_event(uint64_t id, uint64_t output_index, bool enter)
+{
+    auto output = get_output(output_index);
+    if (!output)
+    {
+        return;
+    }
+
+    for_each_handle(id, [=] (auto listener, void *data, auto handle, auto&)
+    {
+        (enter ? listener->output_enter : listener->output_leave)(data, handle, output);
+    });
+}
+
+void replay_parent(uint64_t id, uint64_t parent_id)
+{
+    auto parents = replay_toplevels.find(parent_id);
+    for_each_handle(id, [&] (auto listener, void *data, auto handle, auto& replay_handle)
+    {
+        /* Parents are sent since version 3 */
+        if ((replay_handle.version < 3) || !listener->parent)
+        {
+            return;
+        }
+
+        zwlr_foreign_toplevel_handle_v1 *parent = nullptr;
+        if (parents != replay_toplevels.end())
+        {
+            for (auto& p : parents->second)
+            {
+                if (p.manager == replay_handle.manager)
+                {
+                    parent = (zwlr_foreign_toplevel_handle_v1*)p.handle;
+                }
+            }
+        }
+
+        listener->parent(data, handle, parent);
+    });
+}
+
+void dispatch_event(event_type_t type)
+{
+    auto& log = replay_log;
+    switch (type)
+    {
+      case TOPLEVEL_NEW:
+        replay_new_toplevel(log.varint());
+        break;
+
+      case TOPLEVEL_TITLE:
+      case TOPLEVEL_APP_ID:
+      {
+        auto id    = log.varint();
+        auto value = log.str();
+        for_each_handle(id, [&] (auto listener, void *data, auto handle, auto&)
+        {
+            (type == TOPLEVEL_TITLE ? listener->title : listener->app_id)(
+                data, handle, value.c_str());
+        });
+        break;
+      }
+
+      case TOPLEVEL_OUTPUT_ENTER:
+      case TOPLEVEL_OUTPUT_LEAVE:
+      {
+        auto id = log.varint();
+        replay_output_event(id, log.varint(), type == TOPLEVEL_OUTPUT_ENTER);
+        break;
+      }
+
+      case TOPLEVEL_STATE:
+      {
+        auto id = log.varint();
+        wl_array state;
+        wl_array_init(&state);
+        for (auto count = log.varint(); log.ok && count > 0; count--)
+        {
+            *(uint32_t*)wl_array_add(&state, sizeof(uint32_t)) = log.varint();
+        }
+
+        for_each_handle(id, [&] (auto listener, void *data, auto handle, auto&)
+        {
+            listener->state(data, handle, &state);
+        });
+        wl_array_release(&state);
+        break;
+      }
+
+      case TOPLEVEL_DONE:
+        for_each_handle(log.varint(), [] (auto listener, void *data, auto handle, auto&)
+        {
+            listener->done(data, handle);
+        });
+        break;
+
+      case TOPLEVEL_CLOSED:
+      {
+        /* The components destroy the handles when they are closed */
+        auto id = log.varint();
+        for_each_handle(id, [] (auto listener, void *data, auto handle, auto&)
+        {
+            listener->closed(data, handle);
+        });
+        replay_toplevels.erase(id);
+        break;
+      }
+
+      case TOPLEVEL_PARENT:
+      {
+        auto id = log.varint();
+        replay_parent(id, log.varint());
+        break;
+      }
+
+      case NOTIFY:
+      {
+        auto sender     = log.str();
+        auto parameters = log.variant();
+        if (log.ok)
+        {
+            notify_signal.emit(sender, parameters);
+        }
+
+        break;
+      }
+
+      case SNI_SIGNAL:
+      {
+        auto service    = log.str();
+        auto signal     = log.str();
+        auto parameters = log.variant();
+        if (log.ok)
+        {
+            sni_signal.emit(service, signal, parameters);
+        }
+
+        break;
+      }
+
+      default:
+        log.ok = false;
+    }
+}
+
+double get_seconds(const timeval& time)
+{
+    return time.tv_sec + time.tv_usec / 1e6;
+}
+
+void finish_replay()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    WfTrace::instant("replay finished");
+
+    if (!replay_log.ok)
+    {
+        std::cerr << "The replayed event log is corrupt, stopping." << std::endl;
+    }
+
+    std::cout << "Replayed " << replayed_events << " events in " <<
+        (g_get_monotonic_time() - replay_start) / 1e6 << " s, CPU time: " <<
+        get_seconds(usage.ru_utime) - get_seconds(replay_usage.ru_utime) <<
+        " s user, " <<
+        get_seconds(usage.ru_stime) - get_seconds(replay_usage.ru_stime) <<
+        " s system" << std::endl;
+}
+
+void dispatch_next();
+
+void schedule_next()
+{
+    if (replay_log.at_end())
+    {
+        finish_replay();
+        return;
+    }
+
+    replay_time += replay_log.varint();
+    if (replay_max_speed)
+    {
+        Glib::signal_idle().connect_once(&dispatch_next);
+        return;
+    }
+
+    gint64 delay = (replay_start + replay_time - g_get_monotonic_time()) / 1000;
+    WfStats::signal_timeout().connect_once(&dispatch_next, std::max<gint64>(delay, 0));
+}
+
+void dispatch_next()
+{
+    dispatch_event((event_type_t)replay_log.varint());
+    if (replay_display)
+    {
+        wl_display_flush(replay_display);
+    }
+
+    replayed_events++;
+    schedule_next();
+}
+}
+
+void WfEventLog::record(const std::string& file)
+{
+    record_out.open(file, std::ios::binary | std::ios::trunc);
+    if (!record_out)
+    {
+        std::cerr << "Failed to open event log " << file << std::endl;
+        return;
+    }
+
+    pending = std::string(EVENT_LOG_MAGIC, sizeof(EVENT_LOG_MAGIC));
+    put_varint(pending, EVENT_LOG_VERSION);
+    is_recording = true;
+}
+
+bool WfEventLog::recording()
+{
+    return is_recording;
+}
+
+void WfEventLog::replay(const std::string& file)
+{
+    std::ifstream in(file, std::ios::binary);
+    if (!in)
+    {
+        std::cerr << "Failed to open event log " << file << std::endl;
+        return;
+    }
+
+    replay_log.data = std::string{std::istreambuf_iterator<char>(in),
+        std::istreambuf_iterator<char>()};
+    if (replay_log.data.compare(0, sizeof(EVENT_LOG_MAGIC),
+        std::string(EVENT_LOG_MAGIC, sizeof(EVENT_LOG_MAGIC))) != 0)
+    {
+        std::cerr << file << " is not an event log" << std::endl;
+        return;
+    }
+
+    replay_log.pos = sizeof(EVENT_LOG_MAGIC);
+    if (replay_log.varint() != EVENT_LOG_VERSION)
+    {
+        std::cerr << "Unsupported version of event log " << file << std::endl;
+        return;
+    }
+
+    is_replaying = true;
+}
+
+bool WfEventLog::replaying()
+{
+    return is_replaying;
+}
+
+void WfEventLog::set_max_speed(bool max_speed)
+{
+    replay_max_speed = max_speed;
+}
+
+void WfEventLog::start_replay()
+{
+    if (!is_replaying)
+    {
+        return;
+    }
+
+    replay_start = g_get_monotonic_time();
+    getrusage(RUSAGE_SELF, &replay_usage);
+    WfTrace::instant("replay started");
+    schedule_next();
+}
+
+void WfEventLog::add_manager_listener(zwlr_foreign_toplevel_manager_v1 *manager,
+    const zwlr_foreign_toplevel_manager_v1_listener *listener, void *data)
+{
+    if (is_recording)
+    {
+        recorded_managers.push_back({manager, listener, data});
+        zwlr_foreign_toplevel_manager_v1_add_listener(manager,
+            &recording_manager_listener, &recorded_managers.back());
+        return;
+    }
+
+    zwlr_foreign_toplevel_manager_v1_add_listener(manager, listener, data);
+}
+
+void WfEventLog::add_toplevel_listener(zwlr_foreign_toplevel_handle_v1 *handle,
+    const zwlr_foreign_toplevel_handle_v1_listener *listener, void *data)
+{
+    auto it = recorded_toplevels.find(handle);
+    if ((it != recorded_toplevels.end()) && !it->second.listener)
+    {
+        it->second.listener = listener;
+        it->second.data     = data;
+        zwlr_foreign_toplevel_handle_v1_add_listener(handle,
+            &recording_toplevel_listener, &it->second);
+        return;
+    }
+
+    zwlr_foreign_toplevel_handle_v1_add_listener(handle, listener, data);
+}
+
+void WfEventLog::destroy_manager(zwlr_foreign_toplevel_manager_v1 *manager)
+{
+    if (!manager)
+    {
+        return;
+    }
+
+    auto recorded = std::find_if(recorded_managers.begin(), recorded_managers.end(),
+        [=] (auto& m) { return m.manager == manager; });
+    if (recorded != recorded_managers.end())
+    {
+        /* The toplevels of the recorded manager are closed in the log, and
+         * those of the next manager are announced in their place */
+        bool was_recorded = is_recorded(&*recorded);
+        for (auto it = recorded_toplevels.begin(); it != recorded_toplevels.end();)
+        {
+            if (it->second.manager == &*recorded)
+            {
+                record_toplevel_event(TOPLEVEL_CLOSED, it->second);
+                it = recorded_toplevels.erase(it);
+            } else
+            {
+                ++it;
+            }
+        }
+
+        recorded_managers.erase(recorded);
+        if (was_recorded && !recorded_managers.empty())
+        {
+            announce_toplevels(&recorded_managers.front());
+        }
+    }
+
+    auto proxy = (wl_proxy*)manager;
+    replay_managers.erase(std::remove_if(replay_managers.begin(), replay_managers.end(),
+        [=] (auto& m) { return m.proxy == proxy; }), replay_managers.end());
+    /* The handles are destroyed by the component */
+    for (auto& toplevel : replay_toplevels)
+    {
+        auto& handles = toplevel.second;
+        handles.erase(std::remove_if(handles.begin(), handles.end(),
+            [=] (auto& h) { return h.manager == proxy; }), handles.end());
+    }
+
+    zwlr_foreign_toplevel_manager_v1_destroy(manager);
+}
+
+zwlr_foreign_toplevel_manager_v1*WfEventLog::bind_toplevel_manager(
+    WayfireRegistry& registry, uint32_t max_version)
+{
+    if (!is_replaying)
+    {
+        return registry.bind<zwlr_foreign_toplevel_manager_v1>(
+            &zwlr_foreign_toplevel_manager_v1_interface, max_version);
+    }
+
+    /* A manager which only receives replayed events */
+    if (!replay_display)
+    {
+        connect_replay_display();
+    }
+
+    auto proxy = wl_proxy_create((wl_proxy*)replay_display,
+        &zwlr_foreign_toplevel_manager_v1_interface);
+    replay_managers.push_back({proxy, max_version});
+    return (zwlr_foreign_toplevel_manager_v1*)proxy;
+}
+
+void WfEventLog::record_notify(const Glib::ustring& sender,
+    const Glib::VariantContainerBase& parameters)
+{
+    if (!is_recording)
+    {
+        return;
+    }
+
+    auto& out = begin_event(NOTIFY);
+    put_string(out, sender);
+    put_variant(out, parameters);
+}
+
+void WfEventLog::record_sni_signal(const Glib::ustring& service,
+    const Glib::ustring& signal, const Glib::VariantContainerBase& parameters)
+{
+    if (!is_recording)
+    {
+        return;
+    }
+
+    auto& out = begin_event(SNI_SIGNAL);
+    put_string(out, service);
+    put_string(out, signal);
+    put_variant(out, parameters);
+}
+
+sigc::signal<void(Glib::ustring, Glib::VariantContainerBase)> WfEventLog::replayed_notify_signal()
+{
+    return notify_signal;
+}
+
+sigc::signal<void(Glib::ustring, Glib::ustring,
+    Glib::VariantContainerBase)> WfEventLog::replayed_sni_signal()
+{
+    return sni_signal;
+}
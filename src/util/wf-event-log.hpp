@@ -0,0 +1,72 @@
+#ifndef WF_EVENT_LOG_HPP
+#define WF_EVENT_LOG_HPP
+
+#include <string>
+#include <glibmm/ustring.h>
+#include <glibmm/variant.h>
+#include <sigc++/signal.h>
+#include <wlr-foreign-toplevel-management-unstable-v1-client-protocol.h>
+
+class WayfireRegistry;
+
+/**
+ * Recording and replay of the events which drive the window list, the dock,
+ * the notification daemon and the tray, so that benchmarks with many windows
+ * and busy tray icons can be repeated exactly across builds.
+ *
+ * Recording is enabled with the WF_SHELL_RECORD environment variable or the
+ * --record command line option, both of which give the file to write. The
+ * log contains the events of foreign toplevels, Notify calls and the signals
+ * of StatusNotifierItems and the watcher, in a compact binary format.
+ *
+ * Replay is enabled with WF_SHELL_REPLAY or --replay. The foreign toplevel
+ * managers then receive the logged events instead of the compositor's, while
+ * notifications and tray signals are delivered in addition to those from the
+ * bus. With --replay-speed=max (or WF_SHELL_REPLAY_SPEED=max) the events are
+ * replayed as fast as the main loop allows instead of with their original
+ * timing. Once the log ends, the CPU time used during the replay is printed.
+ */
+namespace WfEventLog
+{
+/* Append events to the given file */
+void record(const std::string& file);
+bool recording();
+
+/* Replay the events of the given file, see start_replay() */
+void replay(const std::string& file);
+bool replaying();
+/* Replay without the original delays between events */
+void set_max_speed(bool max_speed);
+
+/* Start replaying, once the components have been activated */
+void start_replay();
+
+/**
+ * Components must use these instead of binding the manager from the
+ * registry and the add_listener() and destroy() functions of the protocol,
+ * so that their events can be recorded. While replaying, the bound
+ * managers only receive replayed events.
+ */
+zwlr_foreign_toplevel_manager_v1 *bind_toplevel_manager(WayfireRegistry& registry,
+    uint32_t max_version);
+void add_manager_listener(zwlr_foreign_toplevel_manager_v1 *manager,
+    const zwlr_foreign_toplevel_manager_v1_listener *listener, void *data);
+void add_toplevel_listener(zwlr_foreign_toplevel_handle_v1 *handle,
+    const zwlr_foreign_toplevel_handle_v1_listener *listener, void *data);
+void destroy_manager(zwlr_foreign_toplevel_manager_v1 *manager);
+
+/* Record a Notify call to the notification daemon */
+void record_notify(const Glib::ustring& sender,
+    const Glib::VariantContainerBase& parameters);
+/* Record a signal of the StatusNotifierItem with the given service, or of
+ * the StatusNotifierWatcher if the service is empty */
+void record_sni_signal(const Glib::ustring& service, const Glib::ustring& signal,
+    const Glib::VariantContainerBase& parameters);
+
+/* Emitted for replayed Notify calls and tray signals */
+sigc::signal<void(Glib::ustring, Glib::VariantContainerBase)> replayed_notify_signal();
+sigc::signal<void(Glib::ustring, Glib::ustring,
+    Glib::VariantContainerBase)> replayed_sni_signal();
+}
+
+#endif /* end of include guard: WF_EVENT_LOG_HPP */
@@ -0,0 +1,21 @@
+#ifndef WF_OPTION_KEY_HPP
+#define WF_OPTION_KEY_HPP
+
+/**
+ * A typed key for an option from the metadata files. The keys are generated
+ * at build time in wf-shell-options.hpp, as WfOptions::<section>::<option>.
+ */
+template<class Type>
+struct WfOptionKey
+{
+    /* Index of the option in the lookup table of the shell app */
+    int index;
+    /* The full name, as "section/option" */
+    const char *name;
+
+    /* The current value of the option. Cheaper than creating a WfOption
+     * when the value is only needed once. */
+    Type value() const;
+};
+
+#endif /* end of include guard: WF_OPTION_KEY_HPP */
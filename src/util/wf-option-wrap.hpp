@@ -2,10 +2,16 @@
 
 #include <wayfire/config/option-wrapper.hpp>
 #include "wf-shell-app.hpp"
+#include "wf-shell-options.hpp"
 
 /**
  * An implementation of wf::base_option_wrapper_t for wf-shell-app based
  * programs.
+ *
+ * Options from the metadata files should be created from their key in
+ * WfOptions, e.g. WfOption<int>{WfOptions::panel::launchers_size}, so that
+ * unknown options and wrong types fail to compile. Options whose names are
+ * only known at runtime can still be created by name.
  */
 template<class Type>
 class WfOption : public wf::base_option_wrapper_t<Type>
@@ -16,9 +22,31 @@ class WfOption : public wf::base_option_wrapper_t<Type>
         this->load_option(option_name);
     }
 
+    WfOption(const WfOptionKey<Type>& key) : index(key.index)
+    {
+        this->load_option(key.name);
+    }
+
   protected:
+    /* Index in the option table of the shell app, or -1 to look up by name */
+    int index = -1;
+
     std::shared_ptr<wf::config::option_base_t> load_raw_option(const std::string& name) override
     {
+        if (index >= 0)
+        {
+            return WayfireShellApp::get().get_option(index, name);
+        }
+
         return WayfireShellApp::get().config.get_option(name);
     }
 };
+
+template<class Type>
+Type WfOptionKey<Type>::value() const
+{
+    /* The generator maps the metadata types to Type, so the option always
+     * has the right type */
+    auto& option = WayfireShellApp::get().get_option(index, name);
+    return static_cast<wf::config::option_t<Type>*>(option.get())->get_value();
+}
@@ -0,0 +1,81 @@
+#include "wf-registry.hpp"
+#include <algorithm>
+
+const wl_registry_listener WayfireRegistry::listener = {
+    .global = [] (void *data, wl_registry*, uint32_t name,
+                  const char *interface, uint32_t version)
+    {
+        auto self = (WayfireRegistry*)data;
+        self->globals.push_back({name, interface, version});
+        if (self->initialized)
+        {
+            self->m_global_added_signal.emit(self->globals.back());
+        }
+    },
+    .global_remove = [] (void *data, wl_registry*, uint32_t name)
+    {
+        auto self = (WayfireRegistry*)data;
+        auto it   = std::find_if(self->globals.begin(), self->globals.end(),
+            [name] (const global_t& global) { return global.name == name; });
+        if (it != self->globals.end())
+        {
+            auto global = *it;
+            self->globals.erase(it);
+            self->m_global_removed_signal.emit(global);
+        }
+    },
+};
+
+WayfireRegistry::WayfireRegistry(wl_display *display)
+{
+    registry = wl_display_get_registry(display);
+    wl_registry_add_listener(registry, &listener, this);
+    wl_display_roundtrip(display);
+    initialized = true;
+}
+
+WayfireRegistry::~WayfireRegistry()
+{
+    wl_registry_destroy(registry);
+}
+
+const WayfireRegistry::global_t*WayfireRegistry::find(
+    const wl_interface *interface) const
+{
+    for (auto& global : globals)
+    {
+        if (global.interface == interface->name)
+        {
+            return &global;
+        }
+    }
+
+    return nullptr;
+}
+
+bool WayfireRegistry::has(const wl_interface *interface) const
+{
+    return find(interface) != nullptr;
+}
+
+void*WayfireRegistry::bind(const wl_interface *interface, uint32_t max_version)
+{
+    auto global = find(interface);
+    if (!global)
+    {
+        return nullptr;
+    }
+
+    return wl_registry_bind(registry, global->name, interface,
+        std::min(global->version, max_version));
+}
+
+sigc::signal<void(const WayfireRegistry::global_t&)> WayfireRegistry::global_added_signal()
+{
+    return m_global_added_signal;
+}
+
+sigc::signal<void(const WayfireRegistry::global_t&)> WayfireRegistry::global_removed_signal()
+{
+    return m_global_removed_signal;
+}
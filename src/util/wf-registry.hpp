@@ -0,0 +1,65 @@
+#ifndef WF_REGISTRY_HPP
+#define WF_REGISTRY_HPP
+
+#include <string>
+#include <vector>
+#include <sigc++/signal.h>
+#include <wayland-client.h>
+
+/**
+ * The globals advertised by the compositor, shared by all parts of the
+ * shell.
+ *
+ * The registry is read with a single roundtrip when it is created. Globals
+ * are bound only when a component asks for them, which does not need any
+ * further roundtrips.
+ */
+class WayfireRegistry
+{
+  public:
+    struct global_t
+    {
+        uint32_t name;
+        std::string interface;
+        uint32_t version;
+    };
+
+    explicit WayfireRegistry(wl_display *display);
+    ~WayfireRegistry();
+
+    /* Whether the compositor advertises the given interface */
+    bool has(const wl_interface *interface) const;
+
+    /**
+     * Bind the first global with the given interface, with at most
+     * max_version. Each call creates a new object, so that every component
+     * can install its own listener.
+     *
+     * @return The new object, or null if the interface is not advertised.
+     */
+    void *bind(const wl_interface *interface, uint32_t max_version);
+
+    template<class Proxy>
+    Proxy *bind(const wl_interface *interface, uint32_t max_version)
+    {
+        return (Proxy*)bind(interface, max_version);
+    }
+
+    /* Emitted for globals which are added or removed after the creation of
+     * the registry, e.g. outputs */
+    sigc::signal<void(const global_t&)> global_added_signal();
+    sigc::signal<void(const global_t&)> global_removed_signal();
+
+  private:
+    wl_registry *registry;
+    std::vector<global_t> globals;
+    bool initialized = false;
+
+    sigc::signal<void(const global_t&)> m_global_added_signal;
+    sigc::signal<void(const global_t&)> m_global_removed_signal;
+
+    const global_t *find(const wl_interface *interface) const;
+    static const wl_registry_listener listener;
+};
+
+#endif /* end of include guard: WF_REGISTRY_HPP */
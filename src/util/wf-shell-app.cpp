@@ -1,9 +1,20 @@
 #include "wf-shell-app.hpp"
+#include "wf-config-cache.hpp"
+#include "wf-event-log.hpp"
+#include "wf-shell-options.hpp"
+#include "wf-stats.hpp"
+#include "wf-trace.hpp"
+#include "wf-watchdog.hpp"
 #include <glibmm/main.h>
 #include <sys/inotify.h>
 #include <gdk/gdkwayland.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
 #include <iostream>
 #include <memory>
+#include <stdexcept>
 #include <wayfire/config/file.hpp>
 
 #include <unistd.h>
@@ -37,51 +48,184 @@ bool WayfireShellApp::parse_cfgfile(const Glib::ustring & option_name,
     return true;
 }
 
+bool WayfireShellApp::parse_trace_file(const Glib::ustring & option_name,
+    const Glib::ustring & value, bool has_value)
+{
+    WfTrace::enable(value);
+    return true;
+}
+
+/* Parse a watchdog threshold in milliseconds, which must be positive */
+static bool parse_threshold(const std::string& value, int& threshold_ms)
+{
+    char *end;
+    errno = 0;
+    long threshold = strtol(value.c_str(), &end, 10);
+    if (value.empty() || *end || errno || (threshold <= 0) || (threshold > INT_MAX))
+    {
+        std::cerr << "Invalid watchdog threshold \"" << value <<
+            "\", expected a positive number of milliseconds" << std::endl;
+        return false;
+    }
+
+    threshold_ms = threshold;
+    return true;
+}
+
+bool WayfireShellApp::parse_watchdog_threshold(const Glib::ustring & option_name,
+    const Glib::ustring & value, bool has_value)
+{
+    int threshold_ms;
+    if (!parse_threshold(value, threshold_ms))
+    {
+        return false;
+    }
+
+    WfWatchdog::start(threshold_ms);
+    return true;
+}
+
+bool WayfireShellApp::parse_record_file(const Glib::ustring & option_name,
+    const Glib::ustring & value, bool has_value)
+{
+    WfEventLog::record(value);
+    return true;
+}
+
+bool WayfireShellApp::parse_replay_file(const Glib::ustring & option_name,
+    const Glib::ustring & value, bool has_value)
+{
+    WfEventLog::replay(value);
+    return true;
+}
+
+bool WayfireShellApp::parse_replay_speed(const Glib::ustring & option_name,
+    const Glib::ustring & value, bool has_value)
+{
+    if ((value != "original") && (value != "max"))
+    {
+        std::cerr << "Invalid replay speed " << value <<
+            ", expected original or max" << std::endl;
+        return false;
+    }
+
+    WfEventLog::set_max_speed(value == "max");
+    return true;
+}
+
 #define INOT_BUF_SIZE (1024 * sizeof(inotify_event))
 char buf[INOT_BUF_SIZE];
 
-/* Reload file and add next inotify watch */
-static void do_reload_config(WayfireShellApp *app)
+/* How long unplugged monitors may take to come back before their output is
+ * removed, in ms */
+#define OUTPUT_GRACE_PERIOD 3000
+
+/* How long the config file must stay unchanged before it is reloaded, in ms */
+#define CONFIG_RELOAD_DELAY 100
+
+void WayfireShellApp::watch_config()
 {
-    wf::config::load_configuration_options_from_file(
-        app->config, app->get_config_file());
-    app->on_config_reload();
-    inotify_add_watch(app->inotify_fd, app->get_config_file().c_str(), IN_MODIFY);
+    inotify_add_watch(inotify_fd, get_config_file().c_str(),
+        IN_MODIFY | IN_DELETE_SELF | IN_MOVE_SELF);
 }
 
-/* Handle inotify event */
-static bool handle_inotify_event(WayfireShellApp *app, Glib::IOCondition cond)
+const std::shared_ptr<wf::config::option_base_t>& WayfireShellApp::get_option(
+    int index, const std::string& name)
 {
-    /* read, but don't use */
-    read(app->inotify_fd, buf, INOT_BUF_SIZE);
-    do_reload_config(app);
+    auto& option = option_table.at(index);
+    if (!option)
+    {
+        option = config.get_option(name);
+        if (!option)
+        {
+            throw std::runtime_error("No such option: " + name);
+        }
+    }
 
-    return true;
+    return option;
 }
 
-static void registry_add_object(void *data, struct wl_registry *registry,
-    uint32_t name, const char *interface, uint32_t version)
+/* The values of all options, as "section/option" */
+std::map<std::string, std::string> WayfireShellApp::get_option_values()
 {
-    auto app = static_cast<WayfireShellApp*>(data);
-    if (strcmp(interface, zwf_shell_manager_v2_interface.name) == 0)
+    std::map<std::string, std::string> values;
+    for (auto& section : config.get_all_sections())
     {
-        app->wf_shell_manager = (zwf_shell_manager_v2*)wl_registry_bind(registry, name,
-            &zwf_shell_manager_v2_interface, std::min(version, 2u));
+        for (auto& option : section->get_registered_options())
+        {
+            values[section->get_name() + "/" + option->get_name()] =
+                option->get_value_str();
+        }
     }
+
+    return values;
 }
 
-static void registry_remove_object(void *data, struct wl_registry *registry,
-    uint32_t name)
-{}
+/* Reload the file and notify the components about the options which changed */
+bool WayfireShellApp::reload_config()
+{
+    if (rewatch_config)
+    {
+        /* Editors which replace the file remove the old one, and the watch
+         * with it */
+        rewatch_config = false;
+        watch_config();
+    }
+
+    auto old_values = get_option_values();
+    wf::config::load_configuration_options_from_file(config, get_config_file());
+    auto new_values = get_option_values();
+
+    std::set<std::string> changed;
+    for (auto& [name, value] : new_values)
+    {
+        auto it = old_values.find(name);
+        if ((it == old_values.end()) || (it->second != value))
+        {
+            changed.insert(name);
+        }
+    }
+
+    for (auto& [name, value] : old_values)
+    {
+        if (!new_values.count(name))
+        {
+            changed.insert(name);
+        }
+    }
 
-static struct wl_registry_listener registry_listener =
+    if (!changed.empty())
+    {
+        on_config_reload(changed);
+    }
+
+    return false;
+}
+
+bool WayfireShellApp::handle_inotify_event(Glib::IOCondition cond)
 {
-    &registry_add_object,
-    &registry_remove_object
-};
+    ssize_t len = read(inotify_fd, buf, INOT_BUF_SIZE);
+    for (char *ptr = buf; ptr < buf + len;)
+    {
+        auto event = (inotify_event*)ptr;
+        if (event->mask & (IN_IGNORED | IN_DELETE_SELF | IN_MOVE_SELF))
+        {
+            rewatch_config = true;
+        }
+
+        ptr += sizeof(inotify_event) + event->len;
+    }
+
+    reload_conn.disconnect();
+    reload_conn = WfStats::signal_timeout().connect(
+        sigc::mem_fun(this, &WayfireShellApp::reload_config), CONFIG_RELOAD_DELAY);
+
+    return true;
+}
 
 void WayfireShellApp::on_activate()
 {
+    WfTraceSpan span{"WayfireShellApp::on_activate"};
     app->hold();
 
     // load wf-shell if available
@@ -94,24 +238,37 @@ void WayfireShellApp::on_activate()
         std::exit(-1);
     }
 
-    wl_registry *registry = wl_display_get_registry(wl_display);
-    wl_registry_add_listener(registry, &registry_listener, this);
-    wl_display_roundtrip(wl_display);
+    {
+        WfTraceSpan span{"WayfireRegistry"};
+        registry = std::make_unique<WayfireRegistry>(wl_display);
+        wf_shell_manager = registry->bind<zwf_shell_manager_v2>(
+            &zwf_shell_manager_v2_interface, 2);
+    }
 
     std::vector<std::string> xmldirs(1, METADATA_DIR);
 
     // setup config
-    this->config = wf::config::build_configuration(
-        xmldirs, SYSCONF_DIR "/wayfire/wf-shell-defaults.ini",
-        get_config_file());
+    {
+        WfTraceSpan span{"build_configuration"};
+        this->config = WfConfigCache::build_configuration(
+            xmldirs, SYSCONF_DIR "/wayfire/wf-shell-defaults.ini",
+            get_config_file());
+        option_table.assign(WfOptions::count, nullptr);
+    }
 
     inotify_fd = inotify_init();
-    do_reload_config(this);
+    watch_config();
 
     Glib::signal_io().connect(
-        sigc::bind<0>(&handle_inotify_event, this),
+        sigc::mem_fun(this, &WayfireShellApp::handle_inotify_event),
         inotify_fd, Glib::IO_IN | Glib::IO_HUP);
 
+    for (auto& component : components)
+    {
+        WfTraceSpan span{"WayfireShellComponent::on_activate"};
+        component->on_activate();
+    }
+
     // Hook up monitor tracking
     auto display = Gdk::Display::get_default();
     display->signal_monitor_added().connect_notify(
@@ -125,10 +282,39 @@ void WayfireShellApp::on_activate()
     {
         add_output(display->get_monitor(i));
     }
+
+    WfEventLog::start_replay();
 }
 
 void WayfireShellApp::add_output(GMonitor monitor)
 {
+    WfTraceSpan span{"add_output",
+        WfTrace::enabled() ? monitor->get_model() : Glib::ustring()};
+    /* Identical monitors only differ in their place in the layout, so
+     * prefer the output which was at the same position */
+    auto it = detached.end();
+    int best_score = 0;
+    for (auto d = detached.begin(); d != detached.end(); ++d)
+    {
+        int score = d->output->match_score(monitor);
+        if (score > best_score)
+        {
+            it = d;
+            best_score = score;
+        }
+    }
+
+    if (it != detached.end())
+    {
+        it->timeout.disconnect();
+        monitors.push_back(std::move(it->output));
+        detached.erase(it);
+
+        monitors.back()->reattach(monitor, this->wf_shell_manager);
+        handle_output_reattached(monitors.back().get());
+        return;
+    }
+
     monitors.push_back(
         std::make_unique<WayfireOutput>(monitor, this->wf_shell_manager));
     handle_new_output(monitors.back().get());
@@ -136,16 +322,80 @@ void WayfireShellApp::add_output(GMonitor monitor)
 
 void WayfireShellApp::rem_output(GMonitor monitor)
 {
-    auto it = std::remove_if(monitors.begin(), monitors.end(),
+    auto it = std::find_if(monitors.begin(), monitors.end(),
         [monitor] (auto& output) { return output->monitor == monitor; });
 
     if (it != monitors.end())
     {
-        handle_output_removed(it->get());
-        monitors.erase(it, monitors.end());
+        auto output = it->get();
+        detached.push_back({std::move(*it), WfStats::signal_timeout().connect([=] ()
+            {
+                remove_detached(output);
+                return false;
+            }, OUTPUT_GRACE_PERIOD)});
+        monitors.erase(it);
+
+        handle_output_detached(output);
+    }
+}
+
+void WayfireShellApp::remove_detached(WayfireOutput *output)
+{
+    auto it = std::find_if(detached.begin(), detached.end(),
+        [output] (auto& d) { return d.output.get() == output; });
+
+    if (it != detached.end())
+    {
+        handle_output_removed(output);
+        detached.erase(it);
     }
 }
 
+void WayfireShellApp::handle_new_output(WayfireOutput *output)
+{
+    for (auto& component : components)
+    {
+        component->handle_new_output(output);
+    }
+}
+
+void WayfireShellApp::handle_output_removed(WayfireOutput *output)
+{
+    for (auto& component : components)
+    {
+        component->handle_output_removed(output);
+    }
+}
+
+void WayfireShellApp::handle_output_detached(WayfireOutput *output)
+{
+    for (auto& component : components)
+    {
+        component->handle_output_detached(output);
+    }
+}
+
+void WayfireShellApp::handle_output_reattached(WayfireOutput *output)
+{
+    for (auto& component : components)
+    {
+        component->handle_output_reattached(output);
+    }
+}
+
+void WayfireShellApp::on_config_reload(const std::set<std::string>& changed)
+{
+    for (auto& component : components)
+    {
+        component->on_config_reload(changed);
+    }
+}
+
+void WayfireShellApp::add_component(std::unique_ptr<WayfireShellComponent> component)
+{
+    components.push_back(std::move(component));
+}
+
 WayfireShellApp::WayfireShellApp(int argc, char **argv)
 {
     app = Gtk::Application::create(argc, argv, "",
@@ -155,6 +405,53 @@ WayfireShellApp::WayfireShellApp(int argc, char **argv)
     app->add_main_option_entry(
         sigc::mem_fun(this, &WayfireShellApp::parse_cfgfile),
         "config", 'c', "config file to use", "file");
+    app->add_main_option_entry(
+        sigc::mem_fun(this, &WayfireShellApp::parse_trace_file),
+        "trace", '\0', "write a startup trace in the Chrome trace event format", "file");
+
+    app->add_main_option_entry(
+        sigc::mem_fun(this, &WayfireShellApp::parse_watchdog_threshold),
+        "watchdog", '\0', "report main loop stalls longer than the given time", "ms");
+
+    app->add_main_option_entry(
+        sigc::mem_fun(this, &WayfireShellApp::parse_record_file),
+        "record", '\0', "record toplevel, notification and tray events", "file");
+    app->add_main_option_entry(
+        sigc::mem_fun(this, &WayfireShellApp::parse_replay_file),
+        "replay", '\0', "replay recorded events instead of the compositor's", "file");
+    app->add_main_option_entry(
+        sigc::mem_fun(this, &WayfireShellApp::parse_replay_speed),
+        "replay-speed", '\0', "replay with the original timing, or as fast as possible",
+        "original|max");
+
+    if (auto trace_file = getenv("WF_SHELL_TRACE"))
+    {
+        WfTrace::enable(trace_file);
+    }
+
+    int watchdog_threshold;
+    if (auto watchdog_env = getenv("WF_SHELL_WATCHDOG"))
+    {
+        if (parse_threshold(watchdog_env, watchdog_threshold))
+        {
+            WfWatchdog::start(watchdog_threshold);
+        }
+    }
+
+    if (auto record_file = getenv("WF_SHELL_RECORD"))
+    {
+        WfEventLog::record(record_file);
+    }
+
+    if (auto replay_file = getenv("WF_SHELL_REPLAY"))
+    {
+        WfEventLog::replay(replay_file);
+    }
+
+    if (auto replay_speed = getenv("WF_SHELL_REPLAY_SPEED"))
+    {
+        WfEventLog::set_max_speed(std::string(replay_speed) == "max");
+    }
 
     // Activate app after parsing command line
     app->signal_command_line().connect_notify([=] (auto&)
@@ -172,6 +469,16 @@ WayfireShellApp& WayfireShellApp::get()
     return *instance;
 }
 
+void WayfireShellApp::create(int argc, char **argv)
+{
+    if (instance)
+    {
+        throw std::logic_error("Creating WayfireShellApp twice!");
+    }
+
+    instance = std::make_unique<WayfireShellApp>(argc, argv);
+}
+
 void WayfireShellApp::run()
 {
     app->run();
@@ -183,7 +490,13 @@ WayfireOutput::WayfireOutput(const GMonitor& monitor,
 {
     this->monitor = monitor;
     this->wo = gdk_wayland_monitor_get_wl_output(monitor->gobj());
+    this->manufacturer = monitor->get_manufacturer();
+    this->model = monitor->get_model();
+    bind_output(zwf_manager);
+}
 
+void WayfireOutput::bind_output(zwf_shell_manager_v2 *zwf_manager)
+{
     if (zwf_manager)
     {
         this->output =
@@ -191,7 +504,69 @@ WayfireOutput::WayfireOutput(const GMonitor& monitor,
     } else
     {
         this->output = nullptr;
+        return;
+    }
+
+    /* A proxy can have only one listener, so the events are forwarded to
+     * signals which any number of windows can connect to */
+    static const zwf_output_v2_listener listener = {
+        .enter_fullscreen = [] (void *data, zwf_output_v2*)
+        {
+            auto output = (WayfireOutput*)data;
+            output->fullscreen = true;
+            output->enter_fullscreen_signal().emit();
+        },
+        .leave_fullscreen = [] (void *data, zwf_output_v2*)
+        {
+            auto output = (WayfireOutput*)data;
+            output->fullscreen = false;
+            output->leave_fullscreen_signal().emit();
+        },
+        .toggle_menu = [] (void *data, zwf_output_v2*)
+        {
+            ((WayfireOutput*)data)->toggle_menu_signal().emit();
+        },
+    };
+    zwf_output_v2_add_listener(this->output, &listener, this);
+}
+
+int WayfireOutput::match_score(const GMonitor& monitor) const
+{
+    if ((monitor->get_manufacturer().raw() != manufacturer) ||
+        (monitor->get_model().raw() != model))
+    {
+        return 0;
+    }
+
+    /* GTK 3 does not expose the connector name, but the compositor keeps
+     * the position of outputs which are plugged into the same connector.
+     * The old monitor keeps its last geometry after it was unplugged. */
+    Gdk::Rectangle old_geometry, new_geometry;
+    this->monitor->get_geometry(old_geometry);
+    monitor->get_geometry(new_geometry);
+    return old_geometry.equals(new_geometry) ? 2 : 1;
+}
+
+void WayfireOutput::reattach(const GMonitor& monitor,
+    zwf_shell_manager_v2 *zwf_manager)
+{
+    if (this->output)
+    {
+        zwf_output_v2_destroy(this->output);
     }
+
+    /* The new output tells whether it is fullscreen, so that the windows'
+     * autohide counters stay balanced */
+    if (fullscreen)
+    {
+        fullscreen = false;
+        leave_fullscreen_signal().emit();
+    }
+
+    this->monitor = monitor;
+    this->wo = gdk_wayland_monitor_get_wl_output(monitor->gobj());
+    bind_output(zwf_manager);
+    reattached_signal().emit();
 }
 
 WayfireOutput::~WayfireOutput()
@@ -206,3 +581,18 @@ sigc::signal<void()> WayfireOutput::toggle_menu_signal()
 {
     return m_toggle_menu_signal;
 }
+
+sigc::signal<void()> WayfireOutput::enter_fullscreen_signal()
+{
+    return m_enter_fullscreen_signal;
+}
+
+sigc::signal<void()> WayfireOutput::leave_fullscreen_signal()
+{
+    return m_leave_fullscreen_signal;
+}
+
+sigc::signal<void()> WayfireOutput::reattached_signal()
+{
+    return m_reattached_signal;
+}
@@ -1,14 +1,18 @@
 #ifndef WF_SHELL_APP_HPP
 #define WF_SHELL_APP_HPP
 
+#include <map>
+#include <memory>
 #include <set>
 #include <string>
+#include <vector>
 #include <wayfire/config/config-manager.hpp>
 
 #include <gtkmm/application.h>
 #include <gdkmm/monitor.h>
 
 #include "wayfire-shell-unstable-v2-client-protocol.h"
+#include "wf-registry.hpp"
 
 using GMonitor = Glib::RefPtr<Gdk::Monitor>;
 /**
@@ -22,24 +26,116 @@ struct WayfireOutput
     sigc::signal<void()> toggle_menu_signal();
     sigc::signal<void()> m_toggle_menu_signal;
 
+    /* Emitted when a fullscreen view starts or stops covering the output.
+     * Requires zwf_shell_manager_v2 support. */
+    sigc::signal<void()> enter_fullscreen_signal();
+    sigc::signal<void()> leave_fullscreen_signal();
+    sigc::signal<void()> m_enter_fullscreen_signal;
+    sigc::signal<void()> m_leave_fullscreen_signal;
+    bool fullscreen = false;
+
+    /* Emitted when the output got a new monitor after its old one was
+     * unplugged, see WayfireShellComponent::handle_output_reattached() */
+    sigc::signal<void()> reattached_signal();
+    sigc::signal<void()> m_reattached_signal;
+
     WayfireOutput(const GMonitor& monitor, zwf_shell_manager_v2 *zwf_manager);
     ~WayfireOutput();
+
+    /* How closely the monitor resembles the one this output was last
+     * attached to: 0 for a different model, 1 for the same manufacturer and
+     * model, 2 if it also has the same position and size in the layout */
+    int match_score(const GMonitor& monitor) const;
+    void reattach(const GMonitor& monitor, zwf_shell_manager_v2 *zwf_manager);
+
+  private:
+    std::string manufacturer, model;
+    void bind_output(zwf_shell_manager_v2 *zwf_manager);
+};
+
+/**
+ * A part of the shell, such as the panel or the dock.
+ *
+ * Components are run by a WayfireShellApp. Several of them can run in the
+ * same app, sharing the process, the config and the Wayland connection.
+ */
+class WayfireShellComponent
+{
+  public:
+    virtual ~WayfireShellComponent() = default;
+
+    /* Called once the config has been loaded, before the initial outputs
+     * are added */
+    virtual void on_activate()
+    {}
+    virtual void handle_new_output(WayfireOutput *output)
+    {}
+    virtual void handle_output_removed(WayfireOutput *output)
+    {}
+
+    /**
+     * Monitors which are unplugged are not removed right away, because
+     * docking stations and KVM switches often bring them back within a
+     * second. Instead, the output is detached. If a monitor with the same
+     * manufacturer and model is plugged in during the grace period, the
+     * output is reattached to it, otherwise it is removed. Of several
+     * detached outputs of the same model, the one which was at the same
+     * position in the layout is preferred.
+     *
+     * By default, reattached outputs are removed and added again. Components
+     * which can move their windows to the new monitor should override it.
+     */
+    virtual void handle_output_detached(WayfireOutput *output)
+    {}
+    virtual void handle_output_reattached(WayfireOutput *output)
+    {
+        handle_output_removed(output);
+        handle_new_output(output);
+    }
+
+    /* Called after the config file has been reloaded. changed contains the
+     * options whose values changed, as "section/option". */
+    virtual void on_config_reload(const std::set<std::string>& changed)
+    {}
 };
 
 /**
  * A basic shell application.
  *
  * It is suitable for applications that need to show one or more windows
- * per monitor.
+ * per monitor. The windows themselves are created by the components added
+ * to the app.
  */
 class WayfireShellApp
 {
   private:
     std::vector<std::unique_ptr<WayfireOutput>> monitors;
+    std::vector<std::unique_ptr<WayfireShellComponent>> components;
+
+    /* Outputs whose monitor was unplugged, until the grace period ends */
+    struct detached_output_t
+    {
+        std::unique_ptr<WayfireOutput> output;
+        sigc::connection timeout;
+    };
+    std::vector<detached_output_t> detached;
+    void remove_detached(WayfireOutput *output);
+
+    /* Reloads wait until the config file has not been written for a while,
+     * so that editors which write it in several chunks cause only one */
+    sigc::connection reload_conn;
+    /* The watch was removed because the file was replaced */
+    bool rewatch_config = false;
+    bool handle_inotify_event(Glib::IOCondition cond);
+    bool reload_config();
+    void watch_config();
+    std::map<std::string, std::string> get_option_values();
+
+    /* Options looked up through a WfOptionKey, by the key's index */
+    std::vector<std::shared_ptr<wf::config::option_base_t>> option_table;
 
   protected:
-    /** This should be initialized by the subclass in each program which uses
-     * wf-shell-app */
+    /** Set by create(), which each program calls once before run() */
     static std::unique_ptr<WayfireShellApp> instance;
     std::optional<std::string> cmdline_config;
 
@@ -49,19 +145,31 @@ class WayfireShellApp
     virtual void rem_output(GMonitor monitor);
 
     /* The following functions can be overridden in the shell implementation to
-     * handle the events */
+     * handle the events. By default, they are forwarded to the components. */
     virtual void on_activate();
     virtual bool parse_cfgfile(const Glib::ustring & option_name,
         const Glib::ustring & value, bool has_value);
-    virtual void handle_new_output(WayfireOutput *output)
-    {}
-    virtual void handle_output_removed(WayfireOutput *output)
-    {}
+    bool parse_trace_file(const Glib::ustring & option_name,
+        const Glib::ustring & value, bool has_value);
+    bool parse_watchdog_threshold(const Glib::ustring & option_name,
+        const Glib::ustring & value, bool has_value);
+    bool parse_record_file(const Glib::ustring & option_name,
+        const Glib::ustring & value, bool has_value);
+    bool parse_replay_file(const Glib::ustring & option_name,
+        const Glib::ustring & value, bool has_value);
+    bool parse_replay_speed(const Glib::ustring & option_name,
+        const Glib::ustring & value, bool has_value);
+    virtual void handle_new_output(WayfireOutput *output);
+    virtual void handle_output_removed(WayfireOutput *output);
+    virtual void handle_output_detached(WayfireOutput *output);
+    virtual void handle_output_reattached(WayfireOutput *output);
 
   public:
     int inotify_fd;
     wf::config::config_manager_t config;
     zwf_shell_manager_v2 *wf_shell_manager = nullptr;
+    /* The globals of the compositor, valid once the app is activated */
+    std::unique_ptr<WayfireRegistry> registry;
 
     WayfireShellApp(int argc, char **argv);
     virtual ~WayfireShellApp();
@@ -69,8 +177,19 @@ class WayfireShellApp
     virtual std::string get_config_file();
     virtual void run();
 
-    virtual void on_config_reload()
-    {}
+    virtual void on_config_reload(const std::set<std::string>& changed);
+
+    /* Get the option with the given index and name from the generated
+     * WfOptions keys. The option is looked up by name only once. */
+    const std::shared_ptr<wf::config::option_base_t>& get_option(int index,
+        const std::string& name);
+
+    /* Add a component, which is started when the app is activated.
+     * Must be called before run(). */
+    void add_component(std::unique_ptr<WayfireShellComponent> component);
+
+    /* Creates the app instance, get() is valid afterwards */
+    static void create(int argc, char **argv);
 
     /**
      * WayfireShellApp is a singleton class.
@@ -0,0 +1,223 @@
+#include "wf-stats.hpp"
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+#include <unistd.h>
+
+static const auto introspection_data = Gio::DBus::NodeInfo::create_for_xml(
+    R"(
+<?xml version="1.0" encoding="UTF-8"?>
+<node>
+    <interface name="org.wayfire.Shell.Stats">
+        <!-- name, callbacks, time in handlers and drawing (us), relayouts, redraws -->
+        <method name="GetWidgetStats">
+            <arg direction="out" name="widgets" type="a(stttt)"/>
+        </method>
+        <!-- rss, icon_cache_hits, icon_cache_misses, pending_timers, dbus_proxies -->
+        <method name="GetProcessStats">
+            <arg direction="out" name="stats" type="a{sv}"/>
+        </method>
+    </interface>
+</node>
+)")->lookup_interface();
+
+namespace
+{
+uint64_t icon_cache_hits   = 0;
+uint64_t icon_cache_misses = 0;
+uint32_t active_proxies    = 0;
+
+/* Resident set size in bytes */
+uint64_t get_rss()
+{
+    uint64_t size = 0, resident = 0;
+    std::ifstream statm("/proc/self/statm");
+    statm >> size >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+/* Timeouts added through WfStats::signal_timeout() which have not been
+ * removed yet */
+uint32_t pending_timers = 0;
+
+/* Shared by the copies of a timeout's slot, which are destroyed when the
+ * timeout is removed */
+struct timer_guard_t
+{
+    timer_guard_t()
+    {
+        pending_timers++;
+    }
+
+    ~timer_guard_t()
+    {
+        pending_timers--;
+    }
+};
+}
+
+WfStatsScope::WfStatsScope(WfStatsCounters *counters) :
+    counters(counters), start(counters ? g_get_monotonic_time() : 0)
+{}
+
+WfStatsScope::~WfStatsScope()
+{
+    if (counters)
+    {
+        counters->callbacks++;
+        counters->time += g_get_monotonic_time() - start;
+    }
+}
+
+void WfStats::watch_widget(Gtk::Widget& widget, WfStatsCounters *counters)
+{
+    if (!counters)
+    {
+        return;
+    }
+
+    widget.signal_size_allocate().connect_notify(
+        [=] (Gtk::Allocation&) { counters->relayouts++; });
+
+    /* The handlers before and after the default one measure the drawing of
+     * the widget and all its children */
+    auto draw_start = std::make_shared<gint64>(0);
+    widget.signal_draw().connect([=] (const Cairo::RefPtr<Cairo::Context>&)
+    {
+        *draw_start = g_get_monotonic_time();
+        return false;
+    }, false);
+    widget.signal_draw().connect([=] (const Cairo::RefPtr<Cairo::Context>&)
+    {
+        counters->redraws++;
+        counters->time += g_get_monotonic_time() - *draw_start;
+        return false;
+    }, true);
+}
+
+void WfStats::track_proxy(const Glib::RefPtr<Gio::DBus::Proxy>& proxy)
+{
+    if (!proxy)
+    {
+        return;
+    }
+
+    active_proxies++;
+    g_object_weak_ref(G_OBJECT(proxy->gobj()), [] (gpointer, GObject*)
+    {
+        active_proxies--;
+    }, nullptr);
+}
+
+void WfStats::count_icon_lookup(bool hit)
+{
+    (hit ? icon_cache_hits : icon_cache_misses)++;
+}
+
+sigc::connection WfStats::TimeoutSignal::connect(const sigc::slot<bool()>& slot,
+    unsigned int interval, int priority)
+{
+    auto guard = std::make_shared<timer_guard_t>();
+    return Glib::signal_timeout().connect([slot, guard] ()
+    {
+        return slot();
+    }, interval, priority);
+}
+
+void WfStats::TimeoutSignal::connect_once(const sigc::slot<void()>& slot,
+    unsigned int interval, int priority)
+{
+    auto guard = std::make_shared<timer_guard_t>();
+    Glib::signal_timeout().connect_once([slot, guard] ()
+    {
+        slot();
+    }, interval, priority);
+}
+
+sigc::connection WfStats::TimeoutSignal::connect_seconds(const sigc::slot<bool()>& slot,
+    unsigned int interval, int priority)
+{
+    auto guard = std::make_shared<timer_guard_t>();
+    return Glib::signal_timeout().connect_seconds([slot, guard] ()
+    {
+        return slot();
+    }, interval, priority);
+}
+
+WfStats::TimeoutSignal WfStats::signal_timeout()
+{
+    return {};
+}
+
+WfStatsObject::WfStatsObject(const std::string& component) :
+    path("/org/wayfire/Shell/Stats/" + component),
+    dbus_name_id(Gio::DBus::own_name(Gio::DBus::BusType::BUS_TYPE_SESSION,
+        std::string(STATS_IFACE) + "." + component,
+        sigc::mem_fun(this, &WfStatsObject::on_bus_acquired)))
+{}
+
+WfStatsObject::~WfStatsObject()
+{
+    if (connection)
+    {
+        connection->unregister_object(dbus_object_id);
+    }
+
+    Gio::DBus::unown_name(dbus_name_id);
+}
+
+WfStatsCounters*WfStatsObject::get_counters(const std::string& widget)
+{
+    return &widgets[widget];
+}
+
+void WfStatsObject::on_bus_acquired(const Glib::RefPtr<Gio::DBus::Connection> & connection,
+    const Glib::ustring & name)
+{
+    try {
+        dbus_object_id   = connection->register_object(path, introspection_data, interface_table);
+        this->connection = connection;
+    } catch (const Glib::Error& e)
+    {
+        std::cerr << "Failed to export " << path << ": " << e.what() << std::endl;
+    }
+}
+
+void WfStatsObject::on_interface_method_call(const Glib::RefPtr<Gio::DBus::Connection> & connection,
+    const Glib::ustring & sender, const Glib::ustring & object_path,
+    const Glib::ustring & interface_name, const Glib::ustring & method_name,
+    const Glib::VariantContainerBase & parameters,
+    const Glib::RefPtr<Gio::DBus::MethodInvocation> & invocation)
+{
+    if (method_name == "GetWidgetStats")
+    {
+        using widget_stats_t = std::tuple<Glib::ustring, guint64, guint64, guint64, guint64>;
+        std::vector<widget_stats_t> stats;
+        for (auto& [name, counters] : widgets)
+        {
+            stats.emplace_back(name, counters.callbacks, counters.time,
+                counters.relayouts, counters.redraws);
+        }
+
+        invocation->return_value(Glib::Variant<std::tuple<std::vector<widget_stats_t>>>::create(
+            std::tuple(stats)));
+    } else if (method_name == "GetProcessStats")
+    {
+        std::map<Glib::ustring, Glib::VariantBase> stats = {
+            {"rss", Glib::Variant<guint64>::create(get_rss())},
+            {"icon_cache_hits", Glib::Variant<guint64>::create(icon_cache_hits)},
+            {"icon_cache_misses", Glib::Variant<guint64>::create(icon_cache_misses)},
+            {"pending_timers", Glib::Variant<guint32>::create(pending_timers)},
+            {"dbus_proxies", Glib::Variant<guint32>::create(active_proxies)},
+        };
+
+        invocation->return_value(
+            Glib::Variant<std::tuple<std::map<Glib::ustring, Glib::VariantBase>>>::create(
+                std::tuple(stats)));
+    } else
+    {
+        invocation->return_dbus_error("org.freedesktop.DBus.Error.UnknownMethod",
+            "Unknown method " + method_name);
+    }
+}
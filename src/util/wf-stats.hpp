@@ -0,0 +1,108 @@
+#ifndef WF_STATS_HPP
+#define WF_STATS_HPP
+
+#include <giomm.h>
+#include <glibmm/main.h>
+#include <gtkmm/widget.h>
+#include <map>
+#include <string>
+
+/**
+ * Runtime counters of a single panel widget. The widgets of all outputs
+ * with the same name share their counters.
+ */
+struct WfStatsCounters
+{
+    /* Callbacks run by the widget, and the time spent in them and in
+     * drawing the widget, in microseconds */
+    uint64_t callbacks = 0;
+    uint64_t time = 0;
+    uint64_t relayouts = 0;
+    uint64_t redraws   = 0;
+};
+
+/* Counts a callback and the time until the end of the scope. The counters
+ * may be null, e.g. for widgets created outside of a panel. */
+class WfStatsScope
+{
+    WfStatsCounters *counters;
+    gint64 start;
+
+  public:
+    WfStatsScope(WfStatsCounters *counters);
+    ~WfStatsScope();
+
+    WfStatsScope(const WfStatsScope&) = delete;
+    WfStatsScope& operator =(const WfStatsScope&) = delete;
+};
+
+namespace WfStats
+{
+/* Count the relayouts and redraws of a widget, and the time spent drawing
+ * it, into the given counters */
+void watch_widget(Gtk::Widget& widget, WfStatsCounters *counters);
+
+/* Count the proxy as active until it is destroyed */
+void track_proxy(const Glib::RefPtr<Gio::DBus::Proxy>& proxy);
+
+/* Count a lookup in the icon cache */
+void count_icon_lookup(bool hit);
+
+/**
+ * A drop-in replacement for Glib::signal_timeout(), whose timeouts are
+ * counted as pending timers until they are removed. GLib cannot list the
+ * sources of a context, so only the timers of wf-shell itself are counted.
+ */
+class TimeoutSignal
+{
+  public:
+    sigc::connection connect(const sigc::slot<bool()>& slot, unsigned int interval,
+        int priority = Glib::PRIORITY_DEFAULT);
+    void connect_once(const sigc::slot<void()>& slot, unsigned int interval,
+        int priority = Glib::PRIORITY_DEFAULT);
+    sigc::connection connect_seconds(const sigc::slot<bool()>& slot, unsigned int interval,
+        int priority = Glib::PRIORITY_DEFAULT);
+};
+
+TimeoutSignal signal_timeout();
+}
+
+/**
+ * The org.wayfire.Shell.Stats DBus object of a component, which exposes the
+ * counters of its widgets and of the whole process, so that misbehaving
+ * widgets can be found without attaching a profiler.
+ *
+ * The object of the panel is at /org/wayfire/Shell/Stats/Panel on the bus
+ * name org.wayfire.Shell.Stats.Panel, and likewise for other components.
+ */
+class WfStatsObject
+{
+  public:
+    static constexpr auto STATS_IFACE = "org.wayfire.Shell.Stats";
+
+    WfStatsObject(const std::string& component);
+    ~WfStatsObject();
+
+    /* The counters of the widget with the given name */
+    WfStatsCounters *get_counters(const std::string& widget);
+
+  private:
+    std::string path;
+    guint dbus_name_id;
+    guint dbus_object_id = 0;
+    Glib::RefPtr<Gio::DBus::Connection> connection;
+    std::map<std::string, WfStatsCounters> widgets;
+
+    const Gio::DBus::InterfaceVTable interface_table =
+        Gio::DBus::InterfaceVTable(sigc::mem_fun(*this, &WfStatsObject::on_interface_method_call));
+
+    void on_bus_acquired(const Glib::RefPtr<Gio::DBus::Connection> & connection,
+        const Glib::ustring & name);
+    void on_interface_method_call(const Glib::RefPtr<Gio::DBus::Connection> & connection,
+        const Glib::ustring & sender,
+        const Glib::ustring & object_path, const Glib::ustring & interface_name,
+        const Glib::ustring & method_name, const Glib::VariantContainerBase & parameters,
+        const Glib::RefPtr<Gio::DBus::MethodInvocation> & invocation);
+};
+
+#endif /* end of include guard: WF_STATS_HPP */
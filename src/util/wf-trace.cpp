@@ -0,0 +1,143 @@
+#include "wf-trace.hpp"
+#include <glibmm/main.h>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#include <unistd.h>
+
+namespace
+{
+struct event_t
+{
+    std::string name;
+    char phase;
+    long long timestamp, duration;
+    int thread;
+};
+
+std::atomic<bool> tracing{false};
+std::string trace_file;
+std::mutex events_mutex;
+std::vector<event_t> events;
+bool write_scheduled = false;
+
+/* Small thread ids, the main thread is the first one to record an event */
+int get_thread()
+{
+    static std::atomic<int> next_thread{1};
+    thread_local int thread = next_thread++;
+    return thread;
+}
+
+std::string escape(const std::string& str)
+{
+    std::string result;
+    for (char c : str)
+    {
+        if ((c == '"') || (c == '\\'))
+        {
+            result += '\\';
+        }
+
+        result += ((unsigned char)c < 0x20) ? ' ' : c;
+    }
+
+    return result;
+}
+
+bool write_events()
+{
+    std::lock_guard<std::mutex> lock(events_mutex);
+    write_scheduled = false;
+
+    std::ofstream out(trace_file, std::ios::trunc);
+    if (!out)
+    {
+        std::cerr << "Failed to write trace to " << trace_file << std::endl;
+        return false;
+    }
+
+    out << "{\"traceEvents\":[\n";
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        auto& event = events[i];
+        out << "{\"name\":\"" << escape(event.name) << "\",\"cat\":\"wf-shell\"," <<
+            "\"ph\":\"" << event.phase << "\",\"ts\":" << event.timestamp;
+        if (event.phase == 'X')
+        {
+            out << ",\"dur\":" << event.duration;
+        } else
+        {
+            out << ",\"s\":\"p\"";
+        }
+
+        out << ",\"pid\":" << getpid() << ",\"tid\":" << event.thread << "}" <<
+            (i + 1 < events.size() ? ",\n" : "\n");
+    }
+
+    out << "],\"displayTimeUnit\":\"ms\"}\n";
+    return false;
+}
+
+void add_event(event_t event)
+{
+    std::lock_guard<std::mutex> lock(events_mutex);
+    events.push_back(std::move(event));
+
+    /* Rewrite the whole file once the main loop is idle, so that it is
+     * complete even if the process never exits cleanly */
+    if (!write_scheduled)
+    {
+        write_scheduled = true;
+        Glib::MainContext::get_default()->signal_idle().connect(
+            sigc::ptr_fun(&write_events), Glib::PRIORITY_LOW);
+    }
+}
+}
+
+void WfTrace::enable(const std::string& file)
+{
+    trace_file = file;
+    tracing    = true;
+}
+
+bool WfTrace::enabled()
+{
+    return tracing;
+}
+
+/* The name of an event with the detail appended */
+static std::string event_name(const char *name, const std::string& detail)
+{
+    return detail.empty() ? name : std::string(name) + " " + detail;
+}
+
+void WfTrace::instant(const char *name, const std::string& detail)
+{
+    if (tracing)
+    {
+        add_event({event_name(name, detail), 'i', g_get_monotonic_time(), 0, get_thread()});
+    }
+}
+
+WfTraceSpan::WfTraceSpan(const char *name, const std::string& detail) :
+    name(name), start(0)
+{
+    if (tracing)
+    {
+        this->detail = detail;
+        start = g_get_monotonic_time();
+    }
+}
+
+WfTraceSpan::~WfTraceSpan()
+{
+    if (tracing && start)
+    {
+        auto end = g_get_monotonic_time();
+        add_event({event_name(name, detail), 'X', start, end - start, get_thread()});
+    }
+}
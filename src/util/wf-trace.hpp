@@ -0,0 +1,45 @@
+#ifndef WF_TRACE_HPP
+#define WF_TRACE_HPP
+
+#include <string>
+
+/**
+ * Timing spans in the Chrome trace event format, which can be opened in
+ * chrome://tracing or ui.perfetto.dev.
+ *
+ * Tracing is enabled with the WF_SHELL_TRACE environment variable or the
+ * --trace command line option, both of which give the file to write.
+ * The file is rewritten whenever the main loop is idle after new events.
+ */
+namespace WfTrace
+{
+/* Start writing events to the given file */
+void enable(const std::string& file);
+bool enabled();
+
+/* A single point in time, e.g. the first frame */
+void instant(const char *name, const std::string& detail = "");
+}
+
+/**
+ * Records the time from its construction until its destruction.
+ *
+ * The name must be a string literal. The detail, e.g. the name of a widget,
+ * is appended to it, and is only copied while tracing, so that spans cost
+ * only a flag check when tracing is off.
+ */
+class WfTraceSpan
+{
+    const char *name;
+    std::string detail;
+    long long start;
+
+  public:
+    WfTraceSpan(const char *name, const std::string& detail = "");
+    ~WfTraceSpan();
+
+    WfTraceSpan(const WfTraceSpan&) = delete;
+    WfTraceSpan& operator =(const WfTraceSpan&) = delete;
+};
+
+#endif /* end of include guard: WF_TRACE_HPP */
@@ -0,0 +1,165 @@
+#include "wf-watchdog.hpp"
+#include <glib.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include <execinfo.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#define MAX_FRAMES 64
+
+namespace
+{
+std::atomic<gint64> threshold{0};
+pthread_t main_thread;
+int sample_signal;
+
+/* When the current dispatch started, or 0 while the main loop polls */
+std::atomic<gint64> busy_since{0};
+/* Counts the dispatches, to report each stall only once */
+std::atomic<uint64_t> dispatch{0};
+std::atomic<uint64_t> reported_dispatch{0};
+
+/* Filled by the signal handler on the main thread */
+void *frames[MAX_FRAMES];
+int n_frames;
+char source_name[128];
+const GSourceFuncs *source_funcs;
+std::atomic<bool> sampled{false};
+
+void handle_sample_signal(int)
+{
+    n_frames = backtrace(frames, MAX_FRAMES);
+
+    auto source = g_main_current_source();
+    auto name   = source ? g_source_get_name(source) : nullptr;
+    source_funcs = source ? source->source_funcs : nullptr;
+    strncpy(source_name, name ? name : "", sizeof(source_name) - 1);
+
+    sampled.store(true, std::memory_order_release);
+}
+
+const char *describe_source_funcs(const GSourceFuncs *funcs)
+{
+    if (funcs == &g_timeout_funcs)
+    {
+        return "timeout";
+    }
+
+    if (funcs == &g_idle_funcs)
+    {
+        return "idle";
+    }
+
+    if (funcs == &g_io_watch_funcs)
+    {
+        return "io watch";
+    }
+
+    if (funcs == &g_child_watch_funcs)
+    {
+        return "child watch";
+    }
+
+    return funcs ? "other" : "none";
+}
+
+void report_stall(gint64 duration)
+{
+    sampled = false;
+    pthread_kill(main_thread, sample_signal);
+
+    /* The handler runs as soon as the main thread is scheduled */
+    for (int i = 0; i < 100 && !sampled.load(std::memory_order_acquire); i++)
+    {
+        g_usleep(1000);
+    }
+
+    std::cerr << "wf-shell watchdog: main loop stalled for " << duration / 1000 << " ms";
+    if (!sampled.load(std::memory_order_acquire))
+    {
+        std::cerr << ", failed to sample it" << std::endl;
+        return;
+    }
+
+    std::cerr << " in GSource \"" << source_name << "\" (" <<
+        describe_source_funcs(source_funcs) << "), backtrace:" << std::endl;
+    backtrace_symbols_fd(frames, n_frames, STDERR_FILENO);
+}
+
+void watch()
+{
+    uint64_t last_reported = 0;
+    while (true)
+    {
+        g_usleep(threshold / 4);
+
+        gint64 since = busy_since;
+        uint64_t current = dispatch;
+        if (!since || (current == last_reported))
+        {
+            continue;
+        }
+
+        gint64 duration = g_get_monotonic_time() - since;
+        if (duration >= threshold)
+        {
+            last_reported = current;
+            reported_dispatch = current;
+            report_stall(duration);
+        }
+    }
+}
+
+gint watchdog_poll(GPollFD *fds, guint nfds, gint timeout)
+{
+    gint64 since = busy_since.exchange(0);
+    if (since && (reported_dispatch == dispatch))
+    {
+        std::cerr << "wf-shell watchdog: stall ended after " <<
+            (g_get_monotonic_time() - since) / 1000 << " ms" << std::endl;
+    }
+
+    gint result = g_poll(fds, nfds, timeout);
+
+    dispatch++;
+    busy_since = g_get_monotonic_time();
+    return result;
+}
+}
+
+void WfWatchdog::start(int threshold_ms)
+{
+    /* Starting again, e.g. with both the environment variable and the
+     * option set, only changes the threshold */
+    bool running = (threshold != 0);
+    threshold = std::max(threshold_ms, 1) * (gint64)1000;
+    std::cerr << "wf-shell watchdog: reporting main loop stalls over " <<
+        threshold_ms << " ms" << std::endl;
+    if (running)
+    {
+        return;
+    }
+
+    main_thread = pthread_self();
+    sample_signal = SIGRTMIN;
+
+    /* backtrace() loads libgcc on its first call, which must not happen in
+     * the signal handler */
+    void *frame;
+    backtrace(&frame, 1);
+
+    struct sigaction action = {};
+    action.sa_handler = handle_sample_signal;
+    action.sa_flags   = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(sample_signal, &action, nullptr);
+
+    g_main_context_set_poll_func(g_main_context_default(), watchdog_poll);
+    std::thread(watch).detach();
+}
@@ -0,0 +1,25 @@
+#ifndef WF_WATCHDOG_HPP
+#define WF_WATCHDOG_HPP
+
+/**
+ * Reports dispatches of the main loop which take longer than a threshold.
+ *
+ * A thread watches when the main loop leaves and enters poll(). When a
+ * dispatch takes too long, the main thread is interrupted with a signal to
+ * sample the GSource it is running and a backtrace, which are logged with
+ * the duration of the stall. Once the dispatch ends, its total duration is
+ * logged as well.
+ *
+ * The watchdog is enabled with the WF_SHELL_WATCHDOG environment variable
+ * or the --watchdog command line option, both of which give the threshold
+ * in milliseconds. Link with -rdynamic for function names in backtraces,
+ * otherwise they can be resolved with addr2line.
+ */
+namespace WfWatchdog
+{
+/* Start watching the default main context, from the main thread. If the
+ * watchdog is already running, only the threshold is changed. */
+void start(int threshold_ms);
+}
+
+#endif /* end of include guard: WF_WATCHDOG_HPP */
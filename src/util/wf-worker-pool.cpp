@@ -0,0 +1,120 @@
+#include "wf-worker-pool.hpp"
+#include <glibmm/main.h>
+#include <algorithm>
+
+/* Most of the work is disk and memory bound, so a few threads suffice */
+#define MAX_WORKERS 4
+
+std::weak_ptr<WfWorkerPool> WfWorkerPool::instance;
+
+std::shared_ptr<WfWorkerPool> WfWorkerPool::Launch()
+{
+    auto pool = instance.lock();
+    if (!pool)
+    {
+        pool     = std::shared_ptr<WfWorkerPool>(new WfWorkerPool());
+        instance = pool;
+    }
+
+    return pool;
+}
+
+WfWorkerPool::WfWorkerPool()
+{
+    dispatcher.connect(sigc::mem_fun(this, &WfWorkerPool::dispatch_finished));
+
+    int count = std::clamp((int)std::thread::hardware_concurrency(), 1, MAX_WORKERS);
+    for (int i = 0; i < count; i++)
+    {
+        workers.emplace_back(&WfWorkerPool::worker_main, this);
+    }
+}
+
+WfWorkerPool::~WfWorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        exiting = true;
+        pending.clear();
+    }
+
+    pending_cv.notify_all();
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void WfWorkerPool::submit(std::shared_ptr<task_t> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(std::move(task));
+    }
+
+    pending_cv.notify_one();
+}
+
+void WfWorkerPool::worker_main()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        pending_cv.wait(lock, [=] { return exiting || !pending.empty(); });
+        if (exiting)
+        {
+            return;
+        }
+
+        auto task = pending.front();
+        pending.pop_front();
+        if (task->cancelled())
+        {
+            /* Still reported, so that whoever cancelled it knows it won't
+             * run anymore */
+            finished.push_back(task);
+            dispatcher.emit();
+            continue;
+        }
+
+        lock.unlock();
+        task->work();
+        lock.lock();
+
+        finished.push_back(task);
+        dispatcher.emit();
+    }
+}
+
+void WfWorkerPool::dispatch_finished()
+{
+    /* Completions may drop the last reference to the pool, which must stay
+     * alive until all of them have run */
+    auto self = shared_from_this();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!finished.empty())
+        {
+            auto task = finished.front();
+            finished.pop_front();
+
+            /* Completions may submit new work */
+            lock.unlock();
+            if (!task->cancelled())
+            {
+                task->complete();
+            } else
+            {
+                task->stopped();
+            }
+
+            lock.lock();
+        }
+    }
+
+    /* Destroy the pool outside of the handler of its own dispatcher */
+    if (self.use_count() == 1)
+    {
+        Glib::signal_idle().connect_once([self] {});
+    }
+}
@@ -0,0 +1,197 @@
+#ifndef WF_WORKER_POOL_HPP
+#define WF_WORKER_POOL_HPP
+
+#include <glibmm/dispatcher.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+class WfWorkerPool;
+
+/**
+ * The result of work which runs on the worker pool. It is resolved on the
+ * GTK main loop.
+ *
+ * Destroying the future cancels the work: if it has not started yet, it is
+ * skipped, otherwise its result is dropped. Widgets keep the futures of their
+ * work as members, so that nothing is delivered to them after they are gone.
+ */
+template<class T>
+class WfFuture
+{
+  public:
+    using callback_t = std::function<void (T)>;
+
+    WfFuture() = default;
+    WfFuture(WfFuture&& other) = default;
+    WfFuture& operator =(WfFuture&& other)
+    {
+        cancel();
+        state = std::move(other.state);
+        pool  = std::move(other.pool);
+        return *this;
+    }
+
+    ~WfFuture()
+    {
+        cancel();
+    }
+
+    /* Call callback on the main loop once the result is ready, or right away
+     * if it already is. Does nothing if no work was submitted or it was
+     * cancelled. */
+    void then(callback_t callback)
+    {
+        if (!state)
+        {
+            return;
+        }
+
+        if (state->delivered)
+        {
+            callback(std::move(*state->result));
+        } else
+        {
+            state->callback = std::move(callback);
+        }
+    }
+
+    /* Whether the work has been submitted and not resolved yet */
+    bool pending() const
+    {
+        return state && !state->delivered;
+    }
+
+    void cancel()
+    {
+        if (state)
+        {
+            state->cancelled = true;
+            state->callback  = nullptr;
+            state.reset();
+        }
+
+        pool.reset();
+    }
+
+    /* Cancel the work, and call stopped on the main loop once it no longer
+     * runs on a worker, e.g. to start other memory hungry work only after
+     * it. stopped is not called if the pool is destroyed first. */
+    void cancel(std::function<void()> stopped)
+    {
+        if (!pending())
+        {
+            cancel();
+            stopped();
+            return;
+        }
+
+        state->stopped = std::move(stopped);
+        cancel();
+    }
+
+  private:
+    friend class WfWorkerPool;
+    /* Keeps the pool alive until the work is done */
+    std::shared_ptr<WfWorkerPool> pool;
+    struct state_t
+    {
+        /* Written by the worker, read on the main loop once delivered */
+        std::optional<T> result;
+        bool delivered = false;
+        callback_t callback;
+        std::atomic<bool> cancelled{false};
+        /* Called on the main loop once cancelled work has stopped */
+        std::function<void()> stopped;
+    };
+
+    std::shared_ptr<state_t> state;
+};
+
+/**
+ * A small pool of threads for blocking work, such as decoding images or
+ * parsing desktop files, which would otherwise stall the GTK main loop.
+ */
+class WfWorkerPool : public std::enable_shared_from_this<WfWorkerPool>
+{
+  public:
+    /**
+     * Returns the pool instance, creating it if necessary. Must be called
+     * from the main loop.
+     * Once there are no alive shared pointers to the instance, the pool is
+     * destroyed.
+     */
+    static std::shared_ptr<WfWorkerPool> Launch();
+    ~WfWorkerPool();
+
+    /* Run work on a worker thread. T must not be void. */
+    template<class T>
+    WfFuture<T> run(std::function<T()> work)
+    {
+        WfFuture<T> future;
+        future.pool = shared_from_this();
+        auto state = future.state = std::make_shared<typename WfFuture<T>::state_t>();
+
+        auto task = std::make_shared<task_t>();
+        task->cancelled = [state] { return state->cancelled.load(); };
+        task->work = [state, work = std::move(work)] ()
+        {
+            state->result = work();
+        };
+        task->complete = [state] ()
+        {
+            state->delivered = true;
+            if (state->callback)
+            {
+                /* The callback may destroy the future, and with it its own
+                 * closure */
+                auto callback = std::move(state->callback);
+                callback(std::move(*state->result));
+            }
+        };
+        task->stopped = [state] ()
+        {
+            if (state->stopped)
+            {
+                auto stopped = std::move(state->stopped);
+                stopped();
+            }
+        };
+
+        submit(task);
+        return future;
+    }
+
+  private:
+    WfWorkerPool();
+    static std::weak_ptr<WfWorkerPool> instance;
+
+    struct task_t
+    {
+        std::function<bool()> cancelled;
+        std::function<void()> work;
+        /* On the main loop, after the work, or after it was cancelled */
+        std::function<void()> complete;
+        std::function<void()> stopped;
+    };
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable pending_cv;
+    std::deque<std::shared_ptr<task_t>> pending, finished;
+    bool exiting = false;
+
+    Glib::Dispatcher dispatcher;
+    void submit(std::shared_ptr<task_t> task);
+    void worker_main();
+    void dispatch_finished();
+};
+
+#endif /* end of include guard: WF_WORKER_POOL_HPP */